@@ -132,16 +132,27 @@
         ]
       },
       'sources': [
+        'src/async-dispatcher.cc',
         'src/binding.cc',
+        'src/buffer-pool.cc',
+        'src/event-payload.cc',
+        'src/isolate-state.cc',
+        'src/log-sink.cc',
+        'src/latency-histogram.cc',
+        'src/metrics.cc',
         'src/create-offer-observer.cc',
         'src/create-answer-observer.cc',
         'src/set-local-description-observer.cc',
         'src/set-remote-description-observer.cc',
         'src/peerconnection.cc',
+        'src/peerconnectionfactory.cc',
+        'src/receive-ring.cc',
         'src/datachannel.cc',
         'src/rtcstatsreport.cc',
         'src/rtcstatsresponse.cc',
-        'src/stats-observer.cc'
+        'src/stats-observer.cc',
+        'src/stats-sampler.cc',
+        'src/trace.cc'
       ]
     },
     {
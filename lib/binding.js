@@ -0,0 +1,5 @@
+var path = require('path');
+var binary = require('node-pre-gyp');
+var binding_path = binary.find(path.resolve(path.join(__dirname,'../package.json')));
+
+module.exports = require(binding_path);
@@ -1,10 +1,13 @@
 var EventTarget = require('./eventtarget');
 
 var RTCDataChannelMessageEvent = require('./datachannelmessageevent');
+var RTCDataChannelMessagesEvent = require('./datachannelmessagesevent');
+var RTCDataChannelChunkEvent = require('./datachannelchunkevent');
 
 function RTCDataChannel(internalDC) {
   'use strict';
   var that = this;
+  var ringHeader = null;
 
   EventTarget.call(this);
 
@@ -12,8 +15,35 @@ function RTCDataChannel(internalDC) {
     that.dispatchEvent({type: 'error'});
   };
 
-  internalDC.onmessage = function onmessage(data) {
-    that.dispatchEvent(new RTCDataChannelMessageEvent(data));
+  internalDC.onmessage = function onmessage(data, receivedAt) {
+    that.dispatchEvent(new RTCDataChannelMessageEvent(data, receivedAt));
+  };
+
+  // Only called when batchMessages is set: every message drained in one
+  // native pass arrives here as a single array.
+  internalDC.onmessages = function onmessages(messages, receivedAt) {
+    that.dispatchEvent(new RTCDataChannelMessagesEvent(messages, receivedAt));
+  };
+
+  // Only called when framing and chunkEvents are both set: each piece of a
+  // framed message as it arrives, with |last| set on the final one.
+  internalDC.onchunk = function onchunk(data, last) {
+    that.dispatchEvent(new RTCDataChannelChunkEvent(data, last));
+  };
+
+  internalDC.onringdata = function onringdata() {
+    if (ringHeader) {
+      (Atomics.notify || Atomics.wake)(ringHeader, 0);
+    }
+    that.dispatchEvent({type: 'ringdata'});
+  };
+
+  internalDC.onringfull = function onringfull() {
+    that.dispatchEvent({type: 'ringfull'});
+  };
+
+  internalDC.onbufferedamountlow = function onbufferedamountlow() {
+    that.dispatchEvent({type: 'bufferedamountlow'});
   };
 
   internalDC.onstatechange = function onstatechange(state) {
@@ -35,6 +65,14 @@ function RTCDataChannel(internalDC) {
         return internalDC.bufferedAmount;
       }
     },
+    'bufferedAmountLowThreshold': {
+      get: function getBufferedAmountLowThreshold() {
+        return internalDC.bufferedAmountLowThreshold;
+      },
+      set: function(threshold) {
+        internalDC.bufferedAmountLowThreshold = threshold;
+      }
+    },
     'label': {
       get: function getLabel() {
         return internalDC.label;
@@ -46,6 +84,46 @@ function RTCDataChannel(internalDC) {
         return this.RTCDataStates[state];
       }
     },
+    'batchMessages': {
+      get: function getBatchMessages() {
+        return internalDC.batchMessages;
+      },
+      set: function(batch) {
+        internalDC.batchMessages = !!batch;
+      }
+    },
+    'framing': {
+      get: function getFraming() {
+        return internalDC.framing;
+      },
+      set: function(framing) {
+        internalDC.framing = !!framing;
+      }
+    },
+    'chunkEvents': {
+      get: function getChunkEvents() {
+        return internalDC.chunkEvents;
+      },
+      set: function(chunkEvents) {
+        internalDC.chunkEvents = !!chunkEvents;
+      }
+    },
+    'receiveTimestamps': {
+      get: function getReceiveTimestamps() {
+        return internalDC.receiveTimestamps;
+      },
+      set: function(receiveTimestamps) {
+        internalDC.receiveTimestamps = !!receiveTimestamps;
+      }
+    },
+    'maxChunkSize': {
+      get: function getMaxChunkSize() {
+        return internalDC.maxChunkSize;
+      },
+      set: function(size) {
+        internalDC.maxChunkSize = size;
+      }
+    },
     'binaryType': {
       get: function getBinaryType() {
         var type = internalDC.binaryType;
@@ -64,9 +142,49 @@ function RTCDataChannel(internalDC) {
     internalDC.send(data);
   };
 
+  // Non-standard: sends every message in |messages| with one native call and
+  // returns how many of them the channel accepted.
+  this.sendMany = function sendMany(messages) {
+    return internalDC.sendMany(messages);
+  };
+
   this.close = function close() {
     internalDC.close();
   };
+
+  // Non-standard: while a SharedArrayBuffer is set, incoming messages are
+  // written into it natively instead of firing 'message' (see
+  // RTCDataChannelRingReader). 'ringdata' fires when the ring stops being
+  // empty, after waking any reader blocked in wait(); 'ringfull' fires when
+  // messages start being dropped. Pass null to go back to events.
+  this.setReceiveRing = function setReceiveRing(sharedBuffer) {
+    ringHeader = sharedBuffer ? new Int32Array(sharedBuffer, 0, 4) : null;
+    internalDC.setReceiveRing(sharedBuffer || null);
+  };
+
+  // Non-standard: native counters for this channel. See wrtc.getMetrics().
+  this.getMetrics = function getMetrics() {
+    return internalDC.getMetrics();
+  };
+
+  // Non-standard: percentiles of how long events waited between arriving on
+  // the libwebrtc thread and being handled, in microseconds. Pass true to
+  // start a new measurement window.
+  this.getLatency = function getLatency(reset) {
+    return internalDC.getLatency(!!reset);
+  };
+
+  // Non-standard: hold incoming events in native code until resume() is
+  // called, so a slow consumer can push back on delivery. At most 16 MiB of
+  // messages are held; later ones are dropped with an error event. Closing
+  // the channel ends the pause.
+  this.pause = function pause() {
+    internalDC.pause();
+  };
+
+  this.resume = function resume() {
+    internalDC.resume();
+  };
 }
 
 RTCDataChannel.prototype.RTCDataStates = [
@@ -78,7 +196,8 @@ RTCDataChannel.prototype.RTCDataStates = [
 
 RTCDataChannel.prototype.BinaryTypes = [
   'blob',  // Note: not sure what to do about this, since node doesn't have a Blob API
-  'arraybuffer'
+  'arraybuffer',
+  'nodebuffer'  // Non-standard: binary messages arrive as Node Buffers
 ];
 
 module.exports = RTCDataChannel;
@@ -0,0 +1,8 @@
+function RTCDataChannelChunkEvent(data, last) {
+  'use strict';
+  this.data = data;
+  this.last = last;
+}
+RTCDataChannelChunkEvent.prototype.type = 'chunk';
+
+module.exports = RTCDataChannelChunkEvent;
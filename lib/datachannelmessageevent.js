@@ -1,6 +1,12 @@
-function RTCDataChannelMessageEvent(message) {
+function RTCDataChannelMessageEvent(message, receivedAt) {
   'use strict';
   this.data = message;
+
+  // Set when the channel's receiveTimestamps is on: when the message was
+  // queued natively, in milliseconds on the process.hrtime() clock.
+  if (receivedAt !== undefined) {
+    this.receivedAt = receivedAt;
+  }
 }
 RTCDataChannelMessageEvent.prototype.type = 'message';
 
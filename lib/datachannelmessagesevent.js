@@ -0,0 +1,13 @@
+function RTCDataChannelMessagesEvent(messages, receivedAt) {
+  'use strict';
+  this.data = messages;
+
+  // Set when the channel's receiveTimestamps is on: for each message, when it
+  // was queued natively, in milliseconds on the process.hrtime() clock.
+  if (receivedAt !== undefined) {
+    this.receivedAt = receivedAt;
+  }
+}
+RTCDataChannelMessagesEvent.prototype.type = 'messages';
+
+module.exports = RTCDataChannelMessagesEvent;
@@ -0,0 +1,66 @@
+//
+// Consumer side of a data channel receive ring (see
+// RTCDataChannel.prototype.setReceiveRing and src/receive-ring.h). Usable
+// from any thread that can see the SharedArrayBuffer, typically a worker.
+//
+var HEAD = 0;
+var TAIL = 1;
+var DROPPED = 2;
+var WAITING = 3;
+
+var HEADER_SIZE = 16;
+var RECORD_HEADER_SIZE = 8;
+var WRAP = 0xffffffff;
+var BINARY = 0x1;
+
+function RTCDataChannelRingReader(sharedBuffer) {
+  'use strict';
+  var header = new Int32Array(sharedBuffer, 0, 4);
+  var capacity = (sharedBuffer.byteLength - HEADER_SIZE) & ~7;
+  var view = new DataView(sharedBuffer, HEADER_SIZE, capacity);
+
+  // Returns the next message (a Buffer for binary messages, a string for
+  // text) or null if the ring is empty. Payloads are copied out, so the
+  // space is handed back to the producer straight away.
+  this.read = function read() {
+    var tail = Atomics.load(header, TAIL);
+    if (tail === Atomics.load(header, HEAD)) {
+      return null;
+    }
+
+    var length = view.getUint32(tail, true);
+    if (WRAP === length) {
+      tail = 0;
+      length = view.getUint32(tail, true);
+    }
+    var flags = view.getUint32(tail + 4, true);
+
+    var start = HEADER_SIZE + tail + RECORD_HEADER_SIZE;
+    var payload = Buffer.from(new Uint8Array(sharedBuffer, start, length));
+    var next = (tail + ((RECORD_HEADER_SIZE + length + 7) & ~7)) % capacity;
+    Atomics.store(header, TAIL, next);
+
+    return (flags & BINARY) ? payload : payload.toString('utf8');
+  };
+
+  // Blocks until the ring is non-empty or |timeout| milliseconds pass.
+  // Returns true if there is something to read. Only for worker threads;
+  // the owning RTCDataChannel wakes the waiter from the main thread.
+  this.wait = function wait(timeout) {
+    var tail = Atomics.load(header, TAIL);
+    Atomics.store(header, WAITING, 1);
+    if (tail === Atomics.load(header, HEAD)) {
+      Atomics.wait(header, HEAD, tail, timeout);
+    }
+    Atomics.store(header, WAITING, 0);
+    return tail !== Atomics.load(header, HEAD);
+  };
+
+  Object.defineProperty(this, 'dropped', {
+    get: function getDropped() {
+      return Atomics.load(header, DROPPED);
+    }
+  });
+}
+
+module.exports = RTCDataChannelRingReader;
@@ -0,0 +1,108 @@
+var Duplex = require('stream').Duplex;
+var util = require('util');
+
+//
+// A Duplex stream over an RTCDataChannel.
+//
+// Writes are sent as they come in, but a write's callback is held back while
+// the channel's bufferedAmount is above highWaterMark and released by the
+// native 'bufferedamountlow' event, so write() returns false and 'drain'
+// follows the SCTP send buffer. Incoming messages are pushed as Buffers; when
+// push() returns false, native delivery is paused until the next _read().
+//
+// The channel is closed when the writable side finishes.
+//
+function RTCDataChannelStream(channel, options) {
+  'use strict';
+  if (!(this instanceof RTCDataChannelStream)) {
+    return new RTCDataChannelStream(channel, options);
+  }
+
+  var that = this;
+  options = options || {};
+  if (options.highWaterMark === undefined) {
+    options.highWaterMark = 1024 * 1024;
+  }
+
+  Duplex.call(this, options);
+
+  var highWaterMark = options.highWaterMark;
+  var pendingWrite = null;
+  var paused = false;
+
+  this.channel = channel;
+
+  channel.binaryType = 'nodebuffer';
+  channel.bufferedAmountLowThreshold = Math.floor(highWaterMark / 2);
+
+  function flushWrite(err) {
+    var callback = pendingWrite;
+    pendingWrite = null;
+    if (callback) {
+      callback(err);
+    }
+  }
+
+  channel.addEventListener('open', function onopen() {
+    that.emit('connect');
+    flushWrite();
+  });
+
+  channel.addEventListener('message', function onmessage(evt) {
+    if (!that.push(evt.data) && !paused) {
+      paused = true;
+      channel.pause();
+    }
+  });
+
+  channel.addEventListener('bufferedamountlow', function onbufferedamountlow() {
+    flushWrite();
+  });
+
+  channel.addEventListener('close', function onclose() {
+    flushWrite(new Error('RTCDataChannel closed'));
+    that.push(null);
+  });
+
+  channel.addEventListener('error', function onerror(evt) {
+    that.emit('error', evt instanceof Error ? evt : new Error('RTCDataChannel error'));
+  });
+
+  this._read = function _read() {
+    if (paused) {
+      paused = false;
+      channel.resume();
+    }
+  };
+
+  this._write = function _write(chunk, encoding, callback) {
+    var state = channel.readyState;
+    if ('connecting' === state) {
+      pendingWrite = _write.bind(this, chunk, encoding, callback);
+      return;
+    }
+    if ('open' !== state) {
+      return callback(new Error('RTCDataChannel is ' + state));
+    }
+
+    try {
+      channel.send(chunk);
+    } catch (err) {
+      return callback(err);
+    }
+
+    if (channel.bufferedAmount > highWaterMark) {
+      pendingWrite = callback;
+    } else {
+      callback();
+    }
+  };
+
+  this.once('finish', function onfinish() {
+    channel.close();
+  });
+}
+
+util.inherits(RTCDataChannelStream, Duplex);
+
+module.exports = RTCDataChannelStream;
@@ -1,3 +1,18 @@
 exports.RTCIceCandidate       = require('./icecandidate');
 exports.RTCPeerConnection     = require('./peerconnection');
-exports.RTCSessionDescription = require('./sessiondescription');
\ No newline at end of file
+exports.RTCSessionDescription = require('./sessiondescription');
+exports.RTCDataChannelStream  = require('./datachannelstream');
+exports.RTCDataChannelRingReader = require('./datachannelringreader');
+exports.RTCStatsSampler       = require('./statssampler');
+
+var binding = require('./binding');
+
+exports.setFactoryPoolSize = binding.setFactoryPoolSize;
+exports.getFactoryPoolSize = binding.getFactoryPoolSize;
+exports.getBufferPoolStats = binding.getBufferPoolStats;
+exports.getEventStats = binding.getEventStats;
+exports.getMetrics = binding.getMetrics;
+exports.setTracing = binding.setTracing;
+exports.getTrace = binding.getTrace;
+exports.setLogger = binding.setLogger;
+exports.setLogSeverity = binding.setLogSeverity;
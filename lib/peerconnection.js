@@ -1,9 +1,4 @@
-var path = require('path');
-var binary = require('node-pre-gyp');
-var path = require('path');
-//var binding_opts = require(path.resolve(path.join(__dirname, '../build/wrtc.json')));
-var binding_path = binary.find(path.resolve(path.join(__dirname,'../package.json')));
-var _webrtc = require(binding_path);
+var _webrtc = require('./binding');
 
 var EventTarget = require('./eventtarget');
 
@@ -27,6 +22,9 @@ function RTCPeerConnection(configuration, constraints) {
 
   EventTarget.call(this);
 
+  // The native object, for RTCStatsSampler.
+  Object.defineProperty(this, '_pc', { value: pc });
+
   function checkClosed() {
 //    if(this._closed) {
 //      throw new Error('Peer is closed');
@@ -374,10 +372,25 @@ function RTCPeerConnection(configuration, constraints) {
     return new RTCDataChannel(channel);
   };
 
-  this.getStats = function getStats(onSuccess, onFailure) {
+  // Non-standard |selector|: { types: [...], ids: [...], level: 'debug' }
+  // restricts which reports are collected and converted.
+  this.getStats = function getStats(onSuccess, onFailure, selector) {
     pc.getStats(function(internalRTCStatsResponse) {
       onSuccess(new RTCStatsResponse(internalRTCStatsResponse));
-    }, onFailure);
+    }, onFailure, selector);
+  };
+
+  // Non-standard: like getStats, but |onSuccess| receives a plain object
+  // keyed by report id, converted natively in one pass, whose values are
+  // numbers and booleans where libwebrtc reports them.
+  this.getStatsObject = function getStatsObject(onSuccess, onFailure, selector) {
+    pc.getStatsObject(onSuccess, onFailure, selector);
+  };
+
+  // Non-standard: native counters for this connection, including those of
+  // its data channels. See wrtc.getMetrics().
+  this.getMetrics = function getMetrics() {
+    return pc.getMetrics();
   };
 
   this.close = function close() {
@@ -0,0 +1,49 @@
+var _webrtc = require('./binding');
+
+//
+// Non-standard: samples the stats of many RTCPeerConnections natively every
+// |period| ms and emits one aggregated snapshot per tick to ontick:
+//
+//   { timestamp, total: {...}, peers: [{ label, bytesSent,
+//     bytesSentPerSecond, ..., rtt }] }
+//
+// Counters are totals for the active candidate pair; the *PerSecond rates
+// are computed from the previous tick. Peers stay referenced until removed.
+//
+function RTCStatsSampler(period) {
+  'use strict';
+  var sampler = new _webrtc.StatsSampler(period);
+  var that = this;
+
+  sampler.ontick = function ontick(snapshot) {
+    if (typeof that.ontick === 'function') {
+      that.ontick(snapshot);
+    }
+  };
+
+  Object.defineProperty(this, 'period', {
+    get: function getPeriod() {
+      return sampler.period;
+    }
+  });
+
+  this.ontick = null;
+
+  this.add = function add(peerConnection, label) {
+    sampler.add(peerConnection._pc, label);
+  };
+
+  this.remove = function remove(peerConnection) {
+    return sampler.remove(peerConnection._pc);
+  };
+
+  this.start = function start() {
+    sampler.start();
+  };
+
+  this.stop = function stop() {
+    sampler.stop();
+  };
+}
+
+module.exports = RTCStatsSampler;
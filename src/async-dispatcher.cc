@@ -0,0 +1,98 @@
+#include "async-dispatcher.h"
+
+#include "common.h"
+
+using node_webrtc::AsyncDispatcher;
+
+AsyncDispatcher::AsyncDispatcher(uv_loop_t* loop)
+: _refs(0),
+  _closed(false) {
+  uv_mutex_init(&_lock);
+  uv_async_init(loop, &_async, reinterpret_cast<uv_async_cb>(Run));
+  uv_unref(reinterpret_cast<uv_handle_t*>(&_async));
+
+  _async.data = this;
+}
+
+AsyncDispatcher::~AsyncDispatcher() {
+  uv_mutex_destroy(&_lock);
+}
+
+void AsyncDispatcher::Schedule(Target* target) {
+  uv_mutex_lock(&_lock);
+  if (_closed || target->_scheduled) {
+    uv_mutex_unlock(&_lock);
+    return;
+  }
+  target->_scheduled = true;
+  bool was_empty = _ready.empty();
+  _ready.push_back(target);
+  uv_mutex_unlock(&_lock);
+
+  // A non-empty ready list means a wakeup is already pending.
+  if (was_empty) {
+    uv_async_send(&_async);
+  }
+}
+
+void AsyncDispatcher::Cancel(Target* target) {
+  uv_mutex_lock(&_lock);
+  for (std::vector<Target*>::size_type i = 0; i < _ready.size(); i++) {
+    if (_ready[i] == target) {
+      _ready.erase(_ready.begin() + i);
+      break;
+    }
+  }
+  target->_scheduled = false;
+  uv_mutex_unlock(&_lock);
+
+  // The target may also be waiting in the batch that is running right now.
+  for (std::vector<Target*>::size_type i = 0; i < _batch.size(); i++) {
+    if (_batch[i] == target) {
+      _batch[i] = nullptr;
+    }
+  }
+}
+
+void AsyncDispatcher::Ref() {
+  if (0 == _refs++ && !_closed) {
+    uv_ref(reinterpret_cast<uv_handle_t*>(&_async));
+  }
+}
+
+void AsyncDispatcher::Unref() {
+  if (0 == --_refs && !_closed) {
+    uv_unref(reinterpret_cast<uv_handle_t*>(&_async));
+  }
+}
+
+void AsyncDispatcher::Close() {
+  uv_mutex_lock(&_lock);
+  _closed = true;
+  _ready.clear();
+  uv_mutex_unlock(&_lock);
+
+  uv_close(reinterpret_cast<uv_handle_t*>(&_async), nullptr);
+}
+
+void AsyncDispatcher::Run(uv_async_t* handle, int status) {
+  AsyncDispatcher* self = static_cast<AsyncDispatcher*>(handle->data);
+  TRACE_CALL_P((uintptr_t)self);
+
+  uv_mutex_lock(&self->_lock);
+  self->_ready.swap(self->_batch);
+  for (std::vector<Target*>::size_type i = 0; i < self->_batch.size(); i++) {
+    self->_batch[i]->_scheduled = false;
+  }
+  uv_mutex_unlock(&self->_lock);
+
+  for (std::vector<Target*>::size_type i = 0; i < self->_batch.size(); i++) {
+    Target* target = self->_batch[i];
+    if (target) {
+      target->Run();
+    }
+  }
+  self->_batch.clear();
+
+  TRACE_END;
+}
@@ -0,0 +1,69 @@
+#ifndef SRC_ASYNC_DISPATCHER_H_
+#define SRC_ASYNC_DISPATCHER_H_
+
+#include <vector>
+
+#include "uv.h"
+
+namespace node_webrtc {
+
+//
+// A single uv_async_t shared by every PeerConnection and DataChannel on a
+// loop; each isolate owns one for its own loop (see IsolateState). Objects
+// with pending events put themselves on a ready list with Schedule(); one
+// wakeup then runs every ready object, so the number of libuv handles and
+// async sends no longer grows with the number of connections.
+//
+class AsyncDispatcher {
+ public:
+  class Target {
+   public:
+    Target(): _scheduled(false) {}
+    virtual ~Target() {}
+
+    // Called on the loop thread to drain the target's pending events.
+    virtual void Run() = 0;
+
+   private:
+    friend class AsyncDispatcher;
+
+    // Set while the target is on the ready list, guarded by the dispatcher
+    // lock.
+    bool _scheduled;
+  };
+
+  explicit AsyncDispatcher(uv_loop_t* loop);
+
+  // Adds |target| to the ready list and wakes the loop. Safe from any thread.
+  void Schedule(Target* target);
+
+  // Removes |target| from the ready list. Must be called on the loop thread
+  // before a target is destroyed.
+  void Cancel(Target* target);
+
+  // The dispatcher keeps the loop alive while at least one reference is held.
+  // Both must be called on the loop thread.
+  void Ref();
+  void Unref();
+
+  // Closes the async handle when the owning loop goes away. Later calls to
+  // Schedule() are ignored, so the dispatcher must not be deleted while
+  // libwebrtc threads may still hold targets bound to it.
+  void Close();
+
+ private:
+  ~AsyncDispatcher();
+
+  static void Run(uv_async_t* handle, int status);
+
+  uv_async_t _async;
+  uv_mutex_t _lock;
+  std::vector<Target*> _ready;
+  std::vector<Target*> _batch;
+  int _refs;
+  bool _closed;  // guarded by _lock
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_ASYNC_DISPATCHER_H_
@@ -1,22 +1,48 @@
+#include "nan.h"
 #include "node.h"
+#include "uv.h"
 #include "v8.h"
 
 #include "webrtc/base/ssladapter.h"
 
+#include "buffer-pool.h"
+#include "event-payload.h"
+#include "isolate-state.h"
+#include "log-sink.h"
+#include "metrics.h"
 #include "peerconnection.h"
+#include "peerconnectionfactory.h"
 #include "datachannel.h"
 #include "rtcstatsreport.h"
 #include "rtcstatsresponse.h"
+#include "stats-sampler.h"
+#include "trace.h"
 
 using v8::Handle;
 using v8::Object;
 
-void init(Handle<Object> exports) {
+static uv_once_t ssl_once = UV_ONCE_INIT;
+
+static void InitSSL() {
   rtc::InitializeSSL();
+}
+
+// Runs once per isolate: on the main thread and in every worker_thread that
+// requires the addon.
+void init(Handle<Object> exports) {
+  uv_once(&ssl_once, InitSSL);
+  node_webrtc::IsolateState::Create();
+  node_webrtc::Trace::Init(exports);
+  node_webrtc::LogSink::Init(exports);
+  node_webrtc::BufferPool::Init(exports);
+  node_webrtc::EventPayload::Init(exports);
+  node_webrtc::Metrics::Init(exports);
+  node_webrtc::PeerConnectionFactory::Init(exports);
   node_webrtc::PeerConnection::Init(exports);
   node_webrtc::DataChannel::Init(exports);
   node_webrtc::RTCStatsReport::Init(exports);
   node_webrtc::RTCStatsResponse::Init(exports);
+  node_webrtc::StatsSampler::Init(exports);
 }
 
-NODE_MODULE(wrtc, init)
+NAN_MODULE_WORKER_ENABLED(wrtc, init)
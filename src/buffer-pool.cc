@@ -0,0 +1,178 @@
+#include "buffer-pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+using node_webrtc::BufferPool;
+using v8::FunctionTemplate;
+using v8::Handle;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+
+// Size classes follow typical SCTP message sizes: control and chat-sized
+// messages, single-MTU payloads, and the 16 KiB and 64 KiB chunk sizes
+// applications commonly use to stay under SCTP message limits.
+static const size_t kClassSizes[] = { 64, 256, 1024, 4096, 16384, 65536 };
+static const uint32_t kClassCount = sizeof(kClassSizes) / sizeof(kClassSizes[0]);
+
+// Index of the pseudo-class that tracks allocations too large to pool.
+static const uint32_t kOversized = kClassCount;
+
+// Free blocks beyond this many bytes per class are returned to malloc.
+static const size_t kMaxRetainedPerClass = 4 * 1024 * 1024;
+
+// Precedes every block handed out; keeps the payload 16-byte aligned.
+union BlockHeader {
+  struct {
+    uint32_t klass;
+    size_t size;
+  } info;
+  double align[2];
+};
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct SizeClass {
+  uv_mutex_t lock;
+  FreeBlock* head;
+  size_t retained;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t inUse;
+};
+
+static uv_once_t once = UV_ONCE_INIT;
+static SizeClass* classes;
+
+static void InitClasses() {
+  classes = new SizeClass[kClassCount + 1];
+  for (uint32_t i = 0; i <= kClassCount; i++) {
+    uv_mutex_init(&classes[i].lock);
+    classes[i].head = nullptr;
+    classes[i].retained = 0;
+    classes[i].hits = 0;
+    classes[i].misses = 0;
+    classes[i].inUse = 0;
+  }
+}
+
+static SizeClass* Classes() {
+  uv_once(&once, InitClasses);
+  return classes;
+}
+
+void* BufferPool::Allocate(size_t size) {
+  SizeClass* all = Classes();
+
+  uint32_t klass = 0;
+  while (klass < kClassCount && kClassSizes[klass] < size) {
+    klass++;
+  }
+  SizeClass* sc = &all[klass];
+  size_t block_size = klass == kOversized ? size : kClassSizes[klass];
+
+  void* block = nullptr;
+  uv_mutex_lock(&sc->lock);
+  if (sc->head) {
+    block = sc->head;
+    sc->head = sc->head->next;
+    sc->retained -= block_size;
+    sc->hits++;
+  } else {
+    sc->misses++;
+  }
+  sc->inUse += block_size;
+  uv_mutex_unlock(&sc->lock);
+
+  if (!block) {
+    block = malloc(sizeof(BlockHeader) + block_size);
+    if (!block) {
+      // None of the callers can recover from a failed allocation, and they
+      // run on libwebrtc threads where throwing is not an option.
+      fprintf(stderr, "node-webrtc: out of memory allocating %lu bytes\n",
+              static_cast<unsigned long>(sizeof(BlockHeader) + block_size));
+      abort();
+    }
+  }
+
+  BlockHeader* header = static_cast<BlockHeader*>(block);
+  header->info.klass = klass;
+  header->info.size = block_size;
+  return header + 1;
+}
+
+void BufferPool::Free(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+
+  BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+  uint32_t klass = header->info.klass;
+  size_t block_size = header->info.size;
+  SizeClass* sc = &Classes()[klass];
+
+  bool retain = false;
+  uv_mutex_lock(&sc->lock);
+  sc->inUse -= block_size;
+  if (klass != kOversized && sc->retained + block_size <= kMaxRetainedPerClass) {
+    FreeBlock* free_block = reinterpret_cast<FreeBlock*>(header);
+    free_block->next = sc->head;
+    sc->head = free_block;
+    sc->retained += block_size;
+    retain = true;
+  }
+  uv_mutex_unlock(&sc->lock);
+
+  if (!retain) {
+    free(header);
+  }
+}
+
+BufferPool::Stats BufferPool::Snapshot() {
+  SizeClass* all = Classes();
+  Stats stats = { 0, 0, 0, 0, 0 };
+
+  for (uint32_t i = 0; i <= kClassCount; i++) {
+    uv_mutex_lock(&all[i].lock);
+    if (i == kOversized) {
+      stats.oversized += all[i].misses;
+    } else {
+      stats.hits += all[i].hits;
+      stats.misses += all[i].misses;
+    }
+    stats.bytesRetained += all[i].retained;
+    stats.bytesInUse += all[i].inUse;
+    uv_mutex_unlock(&all[i].lock);
+  }
+
+  return stats;
+}
+
+NAN_METHOD(BufferPool::GetStats) {
+  TRACE_CALL;
+
+  Stats stats = Snapshot();
+  uint64_t pooled = stats.hits + stats.misses;
+
+  Local<Object> result = Nan::New<Object>();
+  result->Set(Nan::New("hits").ToLocalChecked(), Nan::New<Number>(stats.hits));
+  result->Set(Nan::New("misses").ToLocalChecked(), Nan::New<Number>(stats.misses));
+  result->Set(Nan::New("oversized").ToLocalChecked(), Nan::New<Number>(stats.oversized));
+  result->Set(Nan::New("hitRate").ToLocalChecked(),
+      Nan::New<Number>(pooled ? static_cast<double>(stats.hits) / pooled : 0));
+  result->Set(Nan::New("bytesRetained").ToLocalChecked(), Nan::New<Number>(stats.bytesRetained));
+  result->Set(Nan::New("bytesInUse").ToLocalChecked(), Nan::New<Number>(stats.bytesInUse));
+
+  TRACE_END;
+  info.GetReturnValue().Set(result);
+}
+
+void BufferPool::Init(Handle<Object> exports) {
+  exports->Set(Nan::New("getBufferPoolStats").ToLocalChecked(),
+      Nan::New<FunctionTemplate>(GetStats)->GetFunction());
+}
@@ -0,0 +1,56 @@
+#ifndef SRC_BUFFER_POOL_H_
+#define SRC_BUFFER_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nan.h"
+#include "uv.h"
+#include "v8.h"  // IWYU pragma: keep
+
+namespace node_webrtc {
+
+//
+// Process-wide, size-classed free lists for event and message payload
+// allocations. Blocks are usually allocated on a libwebrtc thread and freed
+// on the Node thread (or by V8 when a payload is collected), so every size
+// class has its own lock.
+//
+class BufferPool {
+ public:
+  struct Stats {
+    uint64_t hits;           // allocations served from a free list
+    uint64_t misses;         // allocations that fell through to malloc
+    uint64_t oversized;      // allocations larger than the largest class
+    uint64_t bytesRetained;  // bytes parked on free lists
+    uint64_t bytesInUse;     // bytes handed out and not yet freed
+  };
+
+  static void* Allocate(size_t size);
+  static void Free(void* block);
+  static Stats Snapshot();
+
+  //
+  // Nodejs wrapping.
+  //
+  static void Init(v8::Handle<v8::Object> exports);
+  static NAN_METHOD(GetStats);
+};
+
+//
+// Routes operator new/delete of small, frequently allocated structs through
+// the BufferPool.
+//
+struct Pooled {
+  static void* operator new(size_t size) {
+    return BufferPool::Allocate(size);
+  }
+
+  static void operator delete(void* block) {
+    BufferPool::Free(block);
+  }
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_BUFFER_POOL_H_
@@ -6,37 +6,40 @@
 
 #include "nan.h"
 
-#define WARN(msg) fprintf(stdout, "\033[01;33m native:%s \033[00m\n", msg)
-#define ERROR(msg) fprintf(stdout, "\033[01;32m native:%s \033[00m\n", msg)
-#define INFO(msg) fprintf(stdout, "\033[01;34m native:%s \033[00m\n", msg)
-
-#if defined(TRACING)
-
-#define TRACE(msg) printf("   TRACE: %s\n", msg)
-#define TRACE_S(msg, s) printf("   TRACE: %s : %s\n", msg, s)
-#define TRACE_I(msg, i) printf("   TRACE: %s : %d\n", msg, i)
-#define TRACE_U(msg, u) printf("   TRACE: %s : %u\n", msg, u)
-#define TRACE_X(msg, x) printf("   TRACE: %s : 0x%x\n", msg, x)
-#define TRACE_PTR(msg, p) printf("   TRACE: %s : %p\n", msg, p)
-#define TRACE_CALL printf("-> TRACE: Call::%s\n", __PRETTY_FUNCTION__)
-#define TRACE_CALL_I(p1) printf("-> TRACE: Call::%s(%d)\n", __PRETTY_FUNCTION__, p1)
-#define TRACE_CALL_P(p1) printf("-> TRACE: Call::%s(%lx)\n", __PRETTY_FUNCTION__, p1)
-#define TRACE_END printf("<- Call::%s\n", __PRETTY_FUNCTION__)
-
-#else
-
-#define TRACE(msg)
-#define TRACE_S(msg, s)
-#define TRACE_I(msg, i)
-#define TRACE_U(msg, u)
-#define TRACE_X(msg, x)
-#define TRACE_PTR(msg, x)
-#define TRACE_CALL
-#define TRACE_CALL_I(p1)
-#define TRACE_CALL_P(p1)
-#define TRACE_END
-
-#endif
+#include "log-sink.h"
+#include "trace.h"
+
+// Delivered to the setLogger() callback if one is installed, otherwise
+// written to stdout; see log-sink.h.
+#define WARN(msg) node_webrtc::LogSink::Log(node_webrtc::LogSink::SEVERITY_WARNING, msg)
+#define ERROR(msg) node_webrtc::LogSink::Log(node_webrtc::LogSink::SEVERITY_ERROR, msg)
+#define INFO(msg) node_webrtc::LogSink::Log(node_webrtc::LogSink::SEVERITY_INFO, msg)
+
+//
+// Trace points are recorded into per-thread binary rings when tracing is
+// switched on at runtime with setTracing(); see trace.h. Defining TRACING
+// switches it on from startup. String arguments are not recorded, only the
+// label.
+//
+#define TRACE_EVENT(phase, name, arg) \
+  do { \
+    if (node_webrtc::Trace::enabled()) { \
+      node_webrtc::Trace::Record(phase, name, static_cast<uint64_t>(arg)); \
+    } \
+  } while (0)
+
+#define TRACE(msg) TRACE_EVENT(node_webrtc::Trace::INSTANT, msg, 0)
+#define TRACE_S(msg, s) TRACE_EVENT(node_webrtc::Trace::INSTANT, msg, 0)
+#define TRACE_I(msg, i) TRACE_EVENT(node_webrtc::Trace::INSTANT, msg, i)
+#define TRACE_U(msg, u) TRACE_EVENT(node_webrtc::Trace::INSTANT, msg, u)
+#define TRACE_X(msg, x) TRACE_EVENT(node_webrtc::Trace::INSTANT, msg, x)
+#define TRACE_PTR(msg, p) TRACE_EVENT(node_webrtc::Trace::INSTANT, msg, reinterpret_cast<uintptr_t>(p))
+// TRACE_CALL opens a scope that is closed by TRACE_END or, on paths that
+// return early, when the function returns.
+#define TRACE_CALL node_webrtc::TraceScope _traceScope(__PRETTY_FUNCTION__, 0)
+#define TRACE_CALL_I(p1) node_webrtc::TraceScope _traceScope(__PRETTY_FUNCTION__, static_cast<uint64_t>(p1))
+#define TRACE_CALL_P(p1) node_webrtc::TraceScope _traceScope(__PRETTY_FUNCTION__, static_cast<uint64_t>(p1))
+#define TRACE_END _traceScope.End()
 
 #define THROW_TYPE_ERROR(MSG) \
   return Nan::ThrowTypeError(MSG);
@@ -9,13 +9,13 @@ using node_webrtc::PeerConnection;
 void CreateAnswerObserver::OnSuccess(webrtc::SessionDescriptionInterface* sdp) {
   TRACE_CALL;
   PeerConnection::SdpEvent* data = new PeerConnection::SdpEvent(sdp);
-  parent->QueueEvent(PeerConnection::CREATE_ANSWER_SUCCESS, static_cast<void*>(data));
+  parent->QueueEvent(PeerConnection::CREATE_ANSWER_SUCCESS, data);
   TRACE_END;
 }
 
 void CreateAnswerObserver::OnFailure(const std::string& msg) {
   TRACE_CALL;
   PeerConnection::ErrorEvent* data = new PeerConnection::ErrorEvent(msg);
-  parent->QueueEvent(PeerConnection::CREATE_ANSWER_ERROR, static_cast<void*>(data));
+  parent->QueueEvent(PeerConnection::CREATE_ANSWER_ERROR, data);
   TRACE_END;
 }
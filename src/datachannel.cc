@@ -2,10 +2,18 @@
 
 #include <stdint.h>
 
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "buffer-pool.h"
 #include "common.h"
+#include "isolate-state.h"
+#include "peerconnectionfactory.h"
 
 using node_webrtc::DataChannel;
 using node_webrtc::DataChannelObserver;
+using v8::Array;
 using v8::External;
 using v8::Function;
 using v8::FunctionTemplate;
@@ -15,23 +23,108 @@ using v8::Local;
 using v8::Number;
 using v8::Object;
 using v8::String;
+using v8::Uint32;
 using v8::Value;
 
-Nan::Persistent<Function> DataChannel::constructor;
 #if NODE_MODULE_VERSION < 0x000C
 Nan::Persistent<Function> DataChannel::ArrayBufferConstructor;
 #endif
 
-DataChannelObserver::DataChannelObserver(rtc::scoped_refptr<webrtc::DataChannelInterface> jingleDataChannel) {
+//
+// Framing. Every frame starts with an 8 byte header: a flags byte, three
+// reserved bytes and the big-endian length of the whole message, followed by
+// up to maxChunkSize - 8 bytes of payload. The first frame of each message
+// carries kFrameFirst, so a message cut short by a failed send is dropped as
+// soon as the next one starts instead of being spliced onto it.
+//
+static const size_t kFrameHeaderSize = 8;
+static const uint8_t kFrameLast = 0x1;
+static const uint8_t kFrameText = 0x2;
+static const uint8_t kFrameFirst = 0x4;
+static const size_t kMaxFramedMessageSize = 1024 * 1024 * 1024;
+// The declared length comes from the remote peer, so reassembly only
+// reserves this much up front and grows as payload actually arrives.
+static const size_t kMaxFramePreallocation = 1024 * 1024;
+static const size_t kDefaultMaxChunkSize = 16 * 1024;
+static const size_t kMinMaxChunkSize = 64;
+
+// Message bytes a paused channel holds before it starts dropping messages.
+static const size_t kMaxPausedBytes = 16 * 1024 * 1024;
+
+static size_t ReadFrameLength(const uint8_t* frame) {
+  return (static_cast<size_t>(frame[4]) << 24) | (static_cast<size_t>(frame[5]) << 16) |
+         (static_cast<size_t>(frame[6]) << 8) | static_cast<size_t>(frame[7]);
+}
+
+static void AppendFrames(const webrtc::DataBuffer& message, size_t max_chunk_size, std::vector<webrtc::DataBuffer>* frames) {
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(message.data.data());
+  size_t length = message.size();
+  size_t payload_max = max_chunk_size - kFrameHeaderSize;
+  size_t offset = 0;
+
+  // An empty message still takes one frame.
+  do {
+    size_t payload_size = length - offset < payload_max ? length - offset : payload_max;
+    bool last = offset + payload_size == length;
+
+    frames->push_back(webrtc::DataBuffer(rtc::Buffer(), true));
+    rtc::Buffer& frame_data = frames->back().data;
+    frame_data.SetLength(kFrameHeaderSize + payload_size);
+
+    uint8_t* frame = reinterpret_cast<uint8_t*>(frame_data.data());
+    frame[0] = (0 == offset ? kFrameFirst : 0) | (last ? kFrameLast : 0) | (message.binary ? 0 : kFrameText);
+    frame[1] = frame[2] = frame[3] = 0;
+    frame[4] = static_cast<uint8_t>(length >> 24);
+    frame[5] = static_cast<uint8_t>(length >> 16);
+    frame[6] = static_cast<uint8_t>(length >> 8);
+    frame[7] = static_cast<uint8_t>(length);
+    memcpy(frame + kFrameHeaderSize, data + offset, payload_size);
+
+    offset += payload_size;
+  } while (offset < length);
+}
+
+DataChannel::MessageEvent* DataChannel::MessageEvent::Create(const webrtc::DataBuffer* buffer) {
+  MessageEvent* event = Allocate(buffer->binary, buffer->size());
+  memcpy(static_cast<void*>(event->message), static_cast<const void*>(buffer->data.data()), event->size);
+  return event;
+}
+
+DataChannel::MessageEvent* DataChannel::MessageEvent::Allocate(bool binary, size_t size) {
+  void* block = BufferPool::Allocate(sizeof(MessageEvent) + size);
+  EventPayload::Track(sizeof(MessageEvent) + size);
+  return new (block) MessageEvent(binary, size);
+}
+
+void DataChannel::MessageEvent::Release(MessageEvent* event) {
+  EventPayload::Untrack(sizeof(MessageEvent) + event->size);
+  event->~MessageEvent();
+  BufferPool::Free(event);
+}
+
+DataChannelObserver::DataChannelObserver(rtc::scoped_refptr<webrtc::DataChannelInterface> jingleDataChannel,
+                                         PeerConnectionFactory* factory,
+                                         std::shared_ptr<Metrics> parentMetrics)
+: _factory(factory),
+  _parentMetrics(parentMetrics),
+  _messagesReceived(0),
+  _bytesReceived(0) {
   TRACE_CALL;
-  uv_mutex_init(&lock);
+  PeerConnectionFactory::Ref(_factory);
   _jingleDataChannel = jingleDataChannel;
   _jingleDataChannel->RegisterObserver(this);
   TRACE_END;
 }
 
 DataChannelObserver::~DataChannelObserver() {
+  // Only non-empty if no DataChannel ever adopted this observer.
+  std::vector<DataChannel::AsyncEvent> cached;
+  _events.Swap(&cached);
+  for (std::vector<DataChannel::AsyncEvent>::size_type i = 0; i < cached.size(); i++) {
+    DataChannel::ReleaseEvent(cached[i]);
+  }
   _jingleDataChannel = nullptr;
+  PeerConnectionFactory::Unref(_factory);
 }
 
 void DataChannelObserver::OnStateChange() {
@@ -43,7 +136,9 @@ void DataChannelObserver::OnStateChange() {
 
 void DataChannelObserver::OnMessage(const webrtc::DataBuffer& buffer) {
   TRACE_CALL;
-    DataChannel::MessageEvent* data = new DataChannel::MessageEvent(&buffer);
+    _messagesReceived++;
+    _bytesReceived += buffer.size();
+    DataChannel::MessageEvent* data = DataChannel::MessageEvent::Create(&buffer);
     QueueEvent(DataChannel::MESSAGE, static_cast<void*>(data));
   TRACE_END;
 }
@@ -53,35 +148,55 @@ void DataChannelObserver::QueueEvent(DataChannel::AsyncEventType type, void* dat
   DataChannel::AsyncEvent evt;
   evt.type = type;
   evt.data = data;
-  uv_mutex_lock(&lock);
-  _events.push(evt);
-  uv_mutex_unlock(&lock);
+  evt.queuedAt = uv_hrtime();
+  _events.Push(evt);
   TRACE_END;
 }
 
 DataChannel::DataChannel(node_webrtc::DataChannelObserver* observer)
-: loop(uv_default_loop()),
-  _binaryType(DataChannel::ARRAY_BUFFER) {
-  uv_mutex_init(&lock);
-  uv_async_init(loop, &async, reinterpret_cast<uv_async_cb>(Run));
+: _state(IsolateState::Current()),
+  _dispatcher(_state->dispatcher()),
+  _metrics(observer->_parentMetrics),
+  _shutdown(false),
+  _binaryType(DataChannel::ARRAY_BUFFER),
+  _batchMessages(false),
+  _bufferedAmountLowThreshold(0),
+  _framing(false),
+  _chunkEvents(false),
+  _maxChunkSize(kDefaultMaxChunkSize),
+  _inFrame(false),
+  _frameResync(false),
+  _partial(nullptr),
+  _frameLength(0),
+  _frameOffset(0),
+  _ring(nullptr),
+  _ringOverflow(false),
+  _receiveTimestamps(false),
+  _paused(false),
+  _pauseOverflow(false),
+  _queuedBytes(0),
+  _batchPos(0) {
+  _dispatcher->Ref();
+  _state->AddResource(this);
+  uv_mutex_init(&_ringLock);
 
   _jingleDataChannel = observer->_jingleDataChannel;
   _jingleDataChannel->RegisterObserver(this);
+  _factory = observer->_factory;
+  PeerConnectionFactory::Ref(_factory);
+  _signalingThread = _factory->signalingThread();
 
-  async.data = this;
+  if (observer->_messagesReceived) {
+    _metrics.Add(Metrics::MESSAGES_RECEIVED, observer->_messagesReceived);
+    _metrics.Add(Metrics::BYTES_RECEIVED, observer->_bytesReceived);
+  }
 
-  // Re-queue cached observer events
-  while (true) {
-    uv_mutex_lock(&observer->lock);
-    bool empty = observer->_events.empty();
-    if (empty) {
-      uv_mutex_unlock(&observer->lock);
-      break;
-    }
-    AsyncEvent evt = observer->_events.front();
-    observer->_events.pop();
-    uv_mutex_unlock(&observer->lock);
-    QueueEvent(evt.type, evt.data);
+  // Re-queue cached observer events as they are, so their latency and
+  // receivedAt still count from when the observer first queued them.
+  std::vector<AsyncEvent> cached;
+  observer->_events.Swap(&cached);
+  for (std::vector<AsyncEvent>::size_type i = 0; i < cached.size(); i++) {
+    QueueEvent(cached[i]);
   }
 
   delete observer;
@@ -89,9 +204,65 @@ DataChannel::DataChannel(node_webrtc::DataChannelObserver* observer)
 
 DataChannel::~DataChannel() {
   TRACE_CALL;
+  if (_state) {
+    _state->RemoveResource(this);
+  }
+  Teardown();
+  uv_mutex_destroy(&_ringLock);
   TRACE_END;
 }
 
+void DataChannel::Teardown() {
+  TRACE_CALL;
+  _state = nullptr;
+
+  // Observer callbacks run on the signaling thread and may be queueing an
+  // event right now. Only once the observer is gone is it safe to take this
+  // channel off the dispatcher and drain the queue.
+  if (_jingleDataChannel) {
+    webrtc::DataChannelInterface* channel = _jingleDataChannel.get();
+    _signalingThread->Invoke<void>([channel]() {
+      channel->UnregisterObserver();
+    });
+    _jingleDataChannel = nullptr;
+  }
+  _dispatcher->Cancel(this);
+  Stop();
+  ResetFrame();
+  delete _ring;
+  _ring = nullptr;
+  _ringBuffer.Reset();
+
+  // Free whatever was queued but never handled, including the rest of a
+  // batch held back by pause().
+  uint64_t released = _batch.size() - _batchPos;
+  for (std::vector<AsyncEvent>::size_type i = _batchPos; i < _batch.size(); i++) {
+    ReleaseEvent(_batch[i]);
+  }
+  _batch.clear();
+  _events.Swap(&_batch);
+  for (std::vector<AsyncEvent>::size_type i = 0; i < _batch.size(); i++) {
+    ReleaseEvent(_batch[i]);
+  }
+  _metrics.Add(Metrics::EVENTS_DRAINED, released + _batch.size());
+  _batch.clear();
+  _batchPos = 0;
+
+  if (_factory) {
+    PeerConnectionFactory::Unref(_factory);
+    _factory = nullptr;
+  }
+  TRACE_END;
+}
+
+void DataChannel::ReleaseEvent(const AsyncEvent& event) {
+  if ((DataChannel::MESSAGE | DataChannel::CHUNK) & event.type) {
+    MessageEvent::Release(static_cast<MessageEvent*>(event.data));
+  } else {
+    delete static_cast<EventPayload*>(event.data);
+  }
+}
+
 NAN_METHOD(DataChannel::New) {
   TRACE_CALL;
 
@@ -104,109 +275,284 @@ NAN_METHOD(DataChannel::New) {
 
   DataChannel* obj = new DataChannel(observer);
   obj->Wrap(info.This());
+  info.This()->SetInternalField(kCallbacksField, Nan::New<Array>(CALLBACK_COUNT));
 
   TRACE_END;
   info.GetReturnValue().Set(info.This());
 }
 
 void DataChannel::QueueEvent(AsyncEventType type, void* data) {
-  TRACE_CALL;
   AsyncEvent evt;
   evt.type = type;
   evt.data = data;
-  uv_mutex_lock(&lock);
-  _events.push(evt);
-  uv_mutex_unlock(&lock);
+  evt.queuedAt = uv_hrtime();
+  QueueEvent(evt);
+}
+
+void DataChannel::QueueEvent(const AsyncEvent& evt) {
+  TRACE_CALL;
+  if ((DataChannel::MESSAGE | DataChannel::CHUNK) & evt.type) {
+    MessageEvent* message = static_cast<MessageEvent*>(evt.data);
+    if (_paused && _queuedBytes + message->size > kMaxPausedBytes) {
+      MessageEvent::Release(message);
+      if (!_pauseOverflow.exchange(true)) {
+        QueueEvent(DataChannel::ERROR, new ErrorEvent("Receive buffer full while paused, messages were dropped"));
+      }
+      TRACE_END;
+      return;
+    }
+    _queuedBytes += message->size;
+  }
 
-  uv_async_send(&async);
+  _metrics.Add(Metrics::EVENTS_QUEUED);
+  // A paused channel still needs a wakeup for state changes, so that Run()
+  // can see the channel has closed.
+  if (_events.Push(evt) || (DataChannel::STATE & evt.type && _paused)) {
+    _dispatcher->Schedule(this);
+  }
   TRACE_END;
 }
 
-/*NAN_WEAK_CALLBACK(MessageWeakCallback)
-{
-  P* parameter = data.GetParameter();
-  delete[] parameter->message;
-  parameter->message = nullptr;
-  delete parameter;
-  //Nan::AdjustExternalMemory(-parameter->size);
-}*/
+void DataChannel::Stop() {
+  if (!_shutdown) {
+    _shutdown = true;
+    _dispatcher->Unref();
+  }
+}
 
-void DataChannel::Run(uv_async_t* handle, int status) {
+static void MessageFreeCallback(char* message, void* hint) {
+  DataChannel::MessageEvent* event = static_cast<DataChannel::MessageEvent*>(hint);
+  Nan::AdjustExternalMemory(-static_cast<int>(event->size));
+  DataChannel::MessageEvent::Release(event);
+}
+
+static void MessageWeakCallback(const Nan::WeakCallbackInfo<DataChannel::MessageEvent>& info) {
+  DataChannel::MessageEvent* event = info.GetParameter();
+  Nan::AdjustExternalMemory(-static_cast<int>(event->size));
+  DataChannel::MessageEvent::Release(event);
+}
+
+static const size_t kExternalStringThreshold = 1024;
+
+static bool IsAscii(const char* data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (data[i] & 0x80) {
+      return false;
+    }
+  }
+  return true;
+}
+
+class ExternalMessageString
+: public Nan::ExternalOneByteStringResource
+, public node_webrtc::Pooled {
+ public:
+  explicit ExternalMessageString(DataChannel::MessageEvent* event)
+  : _event(event) {
+    Nan::AdjustExternalMemory(static_cast<int>(_event->size));
+  }
+
+  ~ExternalMessageString() {
+    Nan::AdjustExternalMemory(-static_cast<int>(_event->size));
+    DataChannel::MessageEvent::Release(_event);
+  }
+
+  virtual const char* data() const { return _event->message; }
+  virtual size_t length() const { return _event->size; }
+
+ private:
+  DataChannel::MessageEvent* _event;
+};
+
+Local<Value> DataChannel::CreateMessage(MessageEvent* data, BinaryType binaryType) {
+  if (data->binary && NODE_BUFFER == binaryType) {
+    // The Buffer takes over the event's allocation, like the ArrayBuffer
+    // below, and returns it to the pool from its free callback.
+    Nan::AdjustExternalMemory(static_cast<int>(data->size));
+    return Nan::NewBuffer(data->message, static_cast<uint32_t>(data->size), MessageFreeCallback, data).ToLocalChecked();
+  }
+
+  if (data->binary) {
+    // The ArrayBuffer takes over the event's allocation, so the payload is
+    // not copied again and is freed once the buffer is collected.
+#if NODE_MODULE_VERSION > 0x000B
+    Local<v8::ArrayBuffer> array = v8::ArrayBuffer::New(
+        v8::Isolate::GetCurrent(), data->message, data->size);
+    data->array.Reset(array);
+    data->array.SetWeak(data, MessageWeakCallback, Nan::WeakCallbackType::kParameter);
+    Nan::AdjustExternalMemory(static_cast<int>(data->size));
+#else
+    Local<Object> array = Nan::New(ArrayBufferConstructor)->NewInstance();
+    array->SetIndexedPropertiesToExternalArrayData(
+        data->message, v8::kExternalByteArray, data->size);
+    array->ForceSet(Nan::New("byteLength").ToLocalChecked(), Nan::New<Integer>(static_cast<uint32_t>(data->size)));
+    data->array.Reset(array);
+    data->array.SetWeak(data, MessageWeakCallback, Nan::WeakCallbackType::kParameter);
+    Nan::AdjustExternalMemory(static_cast<int>(data->size));
+#endif
+
+    return array;
+  }
+
+  // Large pure-ASCII payloads (typically JSON) are exposed to V8 as external
+  // strings over the event's allocation instead of being copied onto the heap.
+  if (data->size >= kExternalStringThreshold && IsAscii(data->message, data->size)) {
+    Nan::ExternalOneByteStringResource* resource = new ExternalMessageString(data);
+    return Nan::New(resource).ToLocalChecked();
+  }
+
+  Local<String> str = Nan::New(data->message, data->size).ToLocalChecked();
+  MessageEvent::Release(data);
+
+  return str;
+}
+
+Local<Array> DataChannel::Callbacks() {
+  return handle()->GetInternalField(kCallbacksField).As<Array>();
+}
+
+void DataChannel::Emit(Local<Array> callbacks, Callback callback, int argc, Local<Value> argv[]) {
+  Local<Value> function = callbacks->Get(callback);
+  if (function->IsFunction()) {
+    Nan::MakeCallback(handle(), function.As<Function>(), argc, argv);
+  }
+}
+
+void DataChannel::Run() {
   Nan::HandleScope scope;
-  DataChannel* self = static_cast<DataChannel*>(handle->data);
+  DataChannel* self = this;
   TRACE_CALL_P((uintptr_t)self);
-  Local<Object> dc = self->handle();
   bool do_shutdown = false;
 
-  while (true) {
-    uv_mutex_lock(&self->lock);
-    bool empty = self->_events.empty();
-    if (empty) {
-      uv_mutex_unlock(&self->lock);
-      break;
-    }
-    AsyncEvent evt = self->_events.front();
-    self->_events.pop();
-    uv_mutex_unlock(&self->lock);
+  // Messages received while batching is on are collected here and handed to
+  // onmessages in one call, flushed early if another event type intervenes.
+  Local<Array> messages;
+  Local<Array> times;  // receivedAt for each message, with _receiveTimestamps
+  uint32_t message_count = 0;
+
+  // Looked up once per batch; see kCallbacksField.
+  Local<Array> callbacks = self->Callbacks();
+
+  // While paused, events stay queued. A batch interrupted by pause() keeps
+  // its remaining events in _batch and is resumed from _batchPos. A closed
+  // channel will never be resumed, so the pause is dropped and everything
+  // held is delivered ahead of the close.
+  self->_metrics.Add(Metrics::WAKEUPS);
+  if (self->_paused && self->_jingleDataChannel &&
+      webrtc::DataChannelInterface::kClosed == self->_jingleDataChannel->state()) {
+    self->_paused = false;
+  }
+  if (self->_paused) {
+    TRACE_END;
+    return;
+  }
+  uint64_t start = uv_hrtime();
+  if (self->_batchPos == self->_batch.size()) {
+    self->_batch.clear();
+    self->_batchPos = 0;
+    self->_events.Swap(&self->_batch);
+  }
+  std::vector<AsyncEvent>::size_type first = self->_batchPos;
+
+  while (self->_batchPos < self->_batch.size() && !self->_paused) {
+    AsyncEvent evt = self->_batch[self->_batchPos++];
+    self->_latency.Record(uv_hrtime() - evt.queuedAt);
 
     TRACE_U("evt.type", evt.type);
+    if (message_count && !(DataChannel::MESSAGE & evt.type)) {
+      Local<Value> argv[2];
+      argv[0] = messages;
+      argv[1] = times;
+      self->Emit(callbacks, ON_MESSAGES, times.IsEmpty() ? 1 : 2, argv);
+      times.Clear();
+      message_count = 0;
+    }
+
     if (DataChannel::ERROR & evt.type) {
       DataChannel::ErrorEvent* data = static_cast<DataChannel::ErrorEvent*>(evt.data);
-      Local<Function> callback = Local<Function>::Cast(dc->Get(Nan::New("onerror").ToLocalChecked()));
       Local<Value> argv[1];
       argv[0] = Nan::Error(data->msg.c_str());
-      Nan::MakeCallback(dc, callback, 1, argv);
+      delete data;
+      self->Emit(callbacks, ON_ERROR, 1, argv);
     } else if (DataChannel::STATE & evt.type) {
       StateEvent* data = static_cast<StateEvent*>(evt.data);
-      Local<Function> callback = Local<Function>::Cast(dc->Get(Nan::New("onstatechange").ToLocalChecked()));
       Local<Value> argv[1];
       Local<Integer> state = Nan::New<Integer>((data->state));
+      delete data;
       argv[0] = state;
-      Nan::MakeCallback(dc, callback, 1, argv);
+      self->Emit(callbacks, ON_STATE_CHANGE, 1, argv);
 
       if (self->_jingleDataChannel && webrtc::DataChannelInterface::kClosed == self->_jingleDataChannel->state()) {
         do_shutdown = true;
       }
+    } else if (DataChannel::BUFFERED_AMOUNT_LOW & evt.type) {
+      self->Emit(callbacks, ON_BUFFERED_AMOUNT_LOW, 0, nullptr);
+    } else if (DataChannel::CHUNK & evt.type) {
+      MessageEvent* data = static_cast<MessageEvent*>(evt.data);
+      Local<Value> argv[2];
+      bool last = data->last;
+      self->_queuedBytes -= data->size;
+      argv[0] = CreateMessage(data, self->_binaryType);
+      argv[1] = Nan::New<v8::Boolean>(last);
+      self->Emit(callbacks, ON_CHUNK, 2, argv);
+    } else if (DataChannel::RING_DATA & evt.type) {
+      self->Emit(callbacks, ON_RING_DATA, 0, nullptr);
+    } else if (DataChannel::RING_FULL & evt.type) {
+      self->Emit(callbacks, ON_RING_FULL, 0, nullptr);
     } else if (DataChannel::MESSAGE & evt.type) {
       MessageEvent* data = static_cast<MessageEvent*>(evt.data);
-      Local<Function> callback = Local<Function>::Cast(dc->Get(Nan::New("onmessage").ToLocalChecked()));
-
-      Local<Value> argv[1];
-
-      if (data->binary) {
-#if NODE_MODULE_VERSION > 0x000B
-        Local<v8::ArrayBuffer> array = v8::ArrayBuffer::New(
-            v8::Isolate::GetCurrent(), data->message, data->size);
-#else
-        Local<Object> array = Nan::New(ArrayBufferConstructor)->NewInstance();
-        array->SetIndexedPropertiesToExternalArrayData(
-            data->message, v8::kExternalByteArray, data->size);
-        array->ForceSet(Nan::New("byteLength").ToLocalChecked(), Nan::New<Integer>(static_cast<uint32_t>(data->size)));
-#endif
-        // NanMakeWeakPersistent(callback, data, &MessageWeakCallback);
-
-        argv[0] = array;
-        Nan::MakeCallback(dc, callback, 1, argv);
+      self->_queuedBytes -= data->size;
+      Local<Value> message = CreateMessage(data, self->_binaryType);
+
+      if (self->_batchMessages) {
+        if (0 == message_count) {
+          messages = Nan::New<Array>();
+          if (self->_receiveTimestamps) {
+            times = Nan::New<Array>();
+          }
+        }
+        if (!times.IsEmpty()) {
+          times->Set(message_count, Nan::New<Number>(evt.queuedAt / 1e6));
+        }
+        messages->Set(message_count++, message);
+      } else if (self->_receiveTimestamps) {
+        // Milliseconds on the process.hrtime() clock.
+        Local<Value> argv[2];
+        argv[0] = message;
+        argv[1] = Nan::New<Number>(evt.queuedAt / 1e6);
+        self->Emit(callbacks, ON_MESSAGE, 2, argv);
       } else {
-        Local<String> str = Nan::New(data->message, data->size).ToLocalChecked();
-
-        // cleanup message event
-        delete[] data->message;
-        data->message = nullptr;
-        delete data;
-
-        argv[0] = str;
-        Nan::MakeCallback(dc, callback, 1, argv);
+        Local<Value> argv[1];
+        argv[0] = message;
+        self->Emit(callbacks, ON_MESSAGE, 1, argv);
       }
     }
   }
+  if (message_count) {
+    Local<Value> argv[2];
+    argv[0] = messages;
+    argv[1] = times;
+    self->Emit(callbacks, ON_MESSAGES, times.IsEmpty() ? 1 : 2, argv);
+  }
+  self->_metrics.Add(Metrics::EVENTS_DRAINED, self->_batchPos - first);
+  if (self->_batchPos == self->_batch.size()) {
+    self->_batch.clear();
+    self->_batchPos = 0;
+  }
+
+  // Events that arrived while a held batch was being finished have not been
+  // scheduled on their own.
+  if (!self->_paused && !self->_events.Empty()) {
+    self->_dispatcher->Schedule(self);
+  }
 
   if (do_shutdown) {
-    uv_close(reinterpret_cast<uv_handle_t*>(&self->async), nullptr);
+    self->Stop();
     self->_jingleDataChannel->UnregisterObserver();
     self->_jingleDataChannel = nullptr;
   }
 
+  self->_metrics.Add(Metrics::DRAIN_TIME_NS, uv_hrtime() - start);
   TRACE_END;
 }
 
@@ -219,57 +565,330 @@ void DataChannel::OnStateChange() {
 
 void DataChannel::OnMessage(const webrtc::DataBuffer& buffer) {
   TRACE_CALL;
-  MessageEvent* data = new MessageEvent(&buffer);
-  QueueEvent(DataChannel::MESSAGE, static_cast<void*>(data));
+  if (_framing) {
+    // Counted by OnFrame once the whole message is in.
+    OnFrame(buffer);
+    TRACE_END;
+    return;
+  }
+
+  _metrics.Add(Metrics::MESSAGES_RECEIVED);
+  _metrics.Add(Metrics::BYTES_RECEIVED, buffer.size());
+  if (!WriteToRing(buffer)) {
+    MessageEvent* data = MessageEvent::Create(&buffer);
+    QueueEvent(DataChannel::MESSAGE, static_cast<void*>(data));
+  }
   TRACE_END;
 }
 
-NAN_METHOD(DataChannel::Send) {
-  TRACE_CALL;
+void DataChannel::OnFrame(const webrtc::DataBuffer& buffer) {
+  size_t size = buffer.size();
+  if (size < kFrameHeaderSize) {
+    if (_frameResync) {
+      return;
+    }
+    return FrameError("Truncated data channel frame");
+  }
 
-  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.This());
+  const uint8_t* frame = reinterpret_cast<const uint8_t*>(buffer.data.data());
+  uint8_t flags = frame[0];
+  size_t length = ReadFrameLength(frame);
+  const uint8_t* payload = frame + kFrameHeaderSize;
+  size_t payload_size = size - kFrameHeaderSize;
+  bool last = (flags & kFrameLast) != 0;
+
+  if (flags & kFrameFirst) {
+    // A message still in progress was cut short on the sending side.
+    if (_inFrame) {
+      FrameError("Framed message ended early");
+    }
+    _frameResync = false;
+  } else if (!_inFrame) {
+    // The rest of a broken message; dropped up to the next first frame.
+    if (_frameResync) {
+      return;
+    }
+    return FrameError("Unexpected data channel frame");
+  }
+
+  if (!_inFrame) {
+    if (length > kMaxFramedMessageSize) {
+      return FrameError("Framed message exceeds the maximum size");
+    }
+    // The mode is fixed per message, so toggling chunkEvents never splits
+    // a message between the two delivery styles.
+    _partial = _chunkEvents ? nullptr : MessageEvent::Allocate(!(flags & kFrameText),
+        length < kMaxFramePreallocation ? length : kMaxFramePreallocation);
+    _inFrame = true;
+    _frameLength = length;
+    _frameOffset = 0;
+  }
 
-  if (info[0]->IsString()) {
-    Local<String> str = Local<String>::Cast(info[0]);
-    std::string data = *String::Utf8Value(str);
+  if (length != _frameLength || payload_size > _frameLength - _frameOffset) {
+    return FrameError("Inconsistent data channel frame");
+  }
 
-    webrtc::DataBuffer buffer(data);
-    self->_jingleDataChannel->Send(buffer);
+  if (_partial) {
+    size_t needed = _frameOffset + payload_size;
+    if (needed > _partial->size) {
+      // Double, but never past the declared length, so the buffer is exactly
+      // _frameLength bytes once the last frame is in.
+      size_t capacity = _partial->size * 2 > needed ? _partial->size * 2 : needed;
+      if (capacity > _frameLength) {
+        capacity = _frameLength;
+      }
+      MessageEvent* grown = MessageEvent::Allocate(_partial->binary, capacity);
+      memcpy(grown->message, _partial->message, _frameOffset);
+      MessageEvent::Release(_partial);
+      _partial = grown;
+    }
+    memcpy(_partial->message + _frameOffset, payload, payload_size);
   } else {
-#if NODE_MINOR_VERSION >= 11 || NODE_MAJOR_VERSION > 0
-    Local<v8::ArrayBuffer> arraybuffer;
+    MessageEvent* chunk = MessageEvent::Allocate(true, payload_size);
+    memcpy(chunk->message, payload, payload_size);
+    chunk->last = last;
+    QueueEvent(DataChannel::CHUNK, static_cast<void*>(chunk));
+  }
+  _frameOffset += payload_size;
 
-    if (info[0]->IsArrayBuffer()) {
-      arraybuffer = Local<v8::ArrayBuffer>::Cast(info[0]);
-    } else {
-      Local<v8::ArrayBufferView> view = Local<v8::ArrayBufferView>::Cast(info[0]);
-      arraybuffer = view->Buffer();
+  if (last) {
+    if (_frameOffset != _frameLength) {
+      return FrameError("Framed message ended early");
     }
+    _metrics.Add(Metrics::MESSAGES_RECEIVED);
+    _metrics.Add(Metrics::BYTES_RECEIVED, _frameLength);
+    if (_partial) {
+      QueueEvent(DataChannel::MESSAGE, static_cast<void*>(_partial));
+      _partial = nullptr;
+    }
+    _inFrame = false;
+  }
+}
 
-    v8::ArrayBuffer::Contents content = arraybuffer->Externalize();
-    rtc::Buffer buffer(content.Data(), content.ByteLength());
+bool DataChannel::WriteToRing(const webrtc::DataBuffer& buffer) {
+  uv_mutex_lock(&_ringLock);
+  if (!_ring) {
+    uv_mutex_unlock(&_ringLock);
+    return false;
+  }
+  ReceiveRing::Result result = _ring->Write(buffer.binary, buffer.data.data(), buffer.size());
+  uv_mutex_unlock(&_ringLock);
+
+  // Wake JS only on transitions: the consumer drained the ring (or is
+  // sleeping on it), or the ring just started dropping messages.
+  if (ReceiveRing::FULL == result) {
+    if (!_ringOverflow) {
+      _ringOverflow = true;
+      QueueEvent(DataChannel::RING_FULL, nullptr);
+    }
+  } else {
+    _ringOverflow = false;
+    if (ReceiveRing::WRITTEN_SIGNAL == result) {
+      QueueEvent(DataChannel::RING_DATA, nullptr);
+    }
+  }
+  return true;
+}
 
-#else
-    Local<Object> arraybuffer = Local<Object>::Cast(info[0]);
-    void* data = arraybuffer->GetIndexedPropertiesExternalArrayData();
-    uint32_t data_len = arraybuffer->GetIndexedPropertiesExternalArrayDataLength();
+void DataChannel::ResetFrame() {
+  if (_partial) {
+    MessageEvent::Release(_partial);
+    _partial = nullptr;
+  }
+  _inFrame = false;
+}
 
-    rtc::Buffer buffer(data, data_len);
+void DataChannel::FrameError(const char* msg) {
+  ResetFrame();
+  _frameResync = true;
+  ErrorEvent* data = new ErrorEvent(msg);
+  QueueEvent(DataChannel::ERROR, static_cast<void*>(data));
+}
 
-#endif
+void DataChannel::OnBufferedAmountChange(uint64_t previous_amount) {
+  TRACE_CALL;
+  // Only a drop from above the threshold to at or below it is reported, so
+  // senders get one event per drain rather than one per SCTP acknowledgement.
+  uint64_t threshold = _bufferedAmountLowThreshold.load(std::memory_order_relaxed);
+  if (previous_amount > threshold && _jingleDataChannel->buffered_amount() <= threshold) {
+    QueueEvent(DataChannel::BUFFERED_AMOUNT_LOW, nullptr);
+  }
+  TRACE_END;
+}
+
+bool DataChannel::ToDataBuffer(Local<Value> value, webrtc::DataBuffer* data_buffer) {
+  if (value->IsString()) {
+    // Encode straight into the outgoing DataBuffer; going through Utf8Value
+    // and std::string would copy the payload twice more.
+    Local<String> str = Local<String>::Cast(value);
+    int length = str->Utf8Length();
+
+    data_buffer->binary = false;
+    data_buffer->data.SetLength(length);
+    str->WriteUtf8(data_buffer->data.data(), length, nullptr, String::NO_NULL_TERMINATION);
+    return true;
+  }
 
-    webrtc::DataBuffer data_buffer(buffer, true);
-    self->_jingleDataChannel->Send(data_buffer);
+  // Copy exactly the bytes covered by the argument, once, straight into the
+  // outgoing DataBuffer. The caller's buffer is neither externalized nor
+  // neutered, so slices of pooled Node Buffers stay usable after send().
+  data_buffer->binary = true;
 
 #if NODE_MINOR_VERSION >= 11 || NODE_MAJOR_VERSION > 0
-    arraybuffer->Neuter();
+  if (value->IsArrayBuffer()) {
+    Local<v8::ArrayBuffer> arraybuffer = Local<v8::ArrayBuffer>::Cast(value);
+    v8::ArrayBuffer::Contents content = arraybuffer->GetContents();
+    data_buffer->data.SetData(content.Data(), content.ByteLength());
+  } else if (value->IsArrayBufferView()) {
+    Local<v8::ArrayBufferView> view = Local<v8::ArrayBufferView>::Cast(value);
+#if NODE_MODULE_VERSION >= 46
+    data_buffer->data.SetLength(view->ByteLength());
+    view->CopyContents(data_buffer->data.data(), view->ByteLength());
+#else
+    v8::ArrayBuffer::Contents content = view->Buffer()->GetContents();
+    data_buffer->data.SetData(static_cast<char*>(content.Data()) + view->ByteOffset(), view->ByteLength());
+#endif
+  } else {
+    return false;
+  }
+#else
+  Local<Object> arraybuffer = Local<Object>::Cast(value);
+  void* data = arraybuffer->GetIndexedPropertiesExternalArrayData();
+  uint32_t data_len = arraybuffer->GetIndexedPropertiesExternalArrayDataLength();
+
+  data_buffer->data.SetData(data, data_len);
 #endif
+
+  return true;
+}
+
+uint32_t DataChannel::SendBuffers(const std::vector<webrtc::DataBuffer>& buffers) {
+  if (!_jingleDataChannel) {
+    return 0;
+  }
+
+  // One hop to the signaling thread for the whole batch instead of one per
+  // buffer through the proxy. Sending stops at the first buffer the channel
+  // refuses, so the buffers sent are always a prefix.
+  webrtc::DataChannelInterface* channel = _jingleDataChannel.get();
+  uint32_t sent = _signalingThread->Invoke<uint32_t>([channel, &buffers]() {
+    uint32_t sent = 0;
+    while (sent < buffers.size() && channel->Send(buffers[sent])) {
+      sent++;
+    }
+    return sent;
+  });
+  return sent;
+}
+
+void DataChannel::CountSent(const std::vector<webrtc::DataBuffer>& messages, uint32_t count) {
+  uint64_t bytes = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    bytes += messages[i].size();
+  }
+  _metrics.Add(Metrics::MESSAGES_SENT, count);
+  _metrics.Add(Metrics::BYTES_SENT, bytes);
+}
+
+NAN_METHOD(DataChannel::Send) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.This());
+
+  webrtc::DataBuffer data_buffer(rtc::Buffer(), true);
+  if (!ToDataBuffer(info[0], &data_buffer)) {
+    return Nan::ThrowTypeError("Argument 0 must be a string, ArrayBuffer or ArrayBufferView");
+  }
+
+  if (self->_framing) {
+    if (data_buffer.size() > kMaxFramedMessageSize) {
+      return Nan::ThrowRangeError("Message is too large to frame");
+    }
+    std::vector<webrtc::DataBuffer> frames;
+    AppendFrames(data_buffer, self->_maxChunkSize, &frames);
+    uint32_t sent = self->SendBuffers(frames);
+    if (sent < frames.size()) {
+      // The next message's first frame makes the peer drop what did arrive.
+      return Nan::ThrowError("Failed to send the whole framed message");
+    }
+    self->_metrics.Add(Metrics::MESSAGES_SENT);
+    self->_metrics.Add(Metrics::BYTES_SENT, data_buffer.size());
+  } else if (self->_jingleDataChannel->Send(data_buffer)) {
+    self->_metrics.Add(Metrics::MESSAGES_SENT);
+    self->_metrics.Add(Metrics::BYTES_SENT, data_buffer.size());
   }
 
   TRACE_END;
   return;
 }
 
+NAN_METHOD(DataChannel::SendMany) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.This());
+
+  if (!info[0]->IsArray()) {
+    return Nan::ThrowTypeError("Argument 0 must be an array");
+  }
+
+  // Every message is converted up front, so the only work left for the
+  // signaling thread is handing the buffers to the channel in order.
+  Local<Array> messages = Local<Array>::Cast(info[0]);
+  uint32_t count = messages->Length();
+  std::vector<webrtc::DataBuffer> buffers(count, webrtc::DataBuffer(rtc::Buffer(), true));
+  for (uint32_t i = 0; i < count; i++) {
+    if (!ToDataBuffer(messages->Get(i), &buffers[i])) {
+      return Nan::ThrowTypeError("Every message must be a string, ArrayBuffer or ArrayBufferView");
+    }
+  }
+
+  uint32_t accepted = 0;
+  if (self->_framing) {
+    // A message counts as accepted once its last frame was sent.
+    std::vector<webrtc::DataBuffer> frames;
+    std::vector<size_t> ends;
+    for (uint32_t i = 0; i < count; i++) {
+      if (buffers[i].size() > kMaxFramedMessageSize) {
+        return Nan::ThrowRangeError("Message is too large to frame");
+      }
+      AppendFrames(buffers[i], self->_maxChunkSize, &frames);
+      ends.push_back(frames.size());
+    }
+    uint32_t sent = self->SendBuffers(frames);
+    while (accepted < count && ends[accepted] <= sent) {
+      accepted++;
+    }
+  } else {
+    accepted = self->SendBuffers(buffers);
+  }
+  self->CountSent(buffers, accepted);
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::New<Uint32>(accepted));
+}
+
+NAN_METHOD(DataChannel::GetMetrics) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.This());
+
+  TRACE_END;
+  info.GetReturnValue().Set(self->_metrics.ToObject());
+}
+
+NAN_METHOD(DataChannel::GetLatency) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.This());
+  Local<Object> latency = self->_latency.ToObject();
+  if (info[0]->IsTrue()) {
+    self->_latency.Reset();
+  }
+
+  TRACE_END;
+  info.GetReturnValue().Set(latency);
+}
+
 NAN_METHOD(DataChannel::Close) {
   TRACE_CALL;
 
@@ -284,8 +903,72 @@ NAN_METHOD(DataChannel::Shutdown) {
   TRACE_CALL;
 
   DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.This());
-  if (!uv_is_closing(reinterpret_cast<uv_handle_t*>(&self->async))) {
-    uv_close(reinterpret_cast<uv_handle_t*>(&self->async), nullptr);
+  self->Stop();
+
+  TRACE_END;
+  return;
+}
+
+NAN_METHOD(DataChannel::Pause) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.This());
+  self->_paused = true;
+
+  TRACE_END;
+  return;
+}
+
+NAN_METHOD(DataChannel::Resume) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.This());
+  if (self->_paused) {
+    self->_paused = false;
+    self->_pauseOverflow = false;
+    if (self->_batchPos < self->_batch.size() || !self->_events.Empty()) {
+      self->_dispatcher->Schedule(self);
+    }
+  }
+
+  TRACE_END;
+  return;
+}
+
+NAN_METHOD(DataChannel::SetReceiveRing) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.This());
+  ReceiveRing* ring = nullptr;
+
+  if (!info[0]->IsNull() && !info[0]->IsUndefined()) {
+#if NODE_MODULE_VERSION >= 57
+    if (!info[0]->IsSharedArrayBuffer()) {
+      return Nan::ThrowTypeError("Argument 0 must be a SharedArrayBuffer or null");
+    }
+    Local<v8::SharedArrayBuffer> buffer = Local<v8::SharedArrayBuffer>::Cast(info[0]);
+    v8::SharedArrayBuffer::Contents contents = buffer->GetContents();
+    void* data = contents.Data();
+    size_t length = contents.ByteLength();
+    if (!ReceiveRing::IsValidLength(length)) {
+      return Nan::ThrowRangeError("SharedArrayBuffer is too small or too large for a receive ring");
+    }
+    ring = new ReceiveRing(static_cast<uint8_t*>(data), length);
+
+    self->_ringBuffer.Reset(buffer);
+#else
+    return Nan::ThrowError("Receive rings need SharedArrayBuffer support");
+#endif
+  }
+
+  uv_mutex_lock(&self->_ringLock);
+  ReceiveRing* previous = self->_ring;
+  self->_ring = ring;
+  uv_mutex_unlock(&self->_ringLock);
+  delete previous;
+
+  if (!ring) {
+    self->_ringBuffer.Reset();
   }
 
   TRACE_END;
@@ -343,6 +1026,144 @@ NAN_SETTER(DataChannel::SetBinaryType) {
   TRACE_END;
 }
 
+NAN_GETTER(DataChannel::GetBatchMessages) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(self->_batchMessages));
+}
+
+NAN_SETTER(DataChannel::SetBatchMessages) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+  self->_batchMessages = value->BooleanValue();
+
+  TRACE_END;
+}
+
+NAN_GETTER(DataChannel::GetBufferedAmountLowThreshold) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+  uint64_t threshold = self->_bufferedAmountLowThreshold.load(std::memory_order_relaxed);
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::New<Number>(static_cast<double>(threshold)));
+}
+
+NAN_SETTER(DataChannel::SetBufferedAmountLowThreshold) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+  double threshold = value->NumberValue();
+  if (!(threshold >= 0)) {
+    threshold = 0;
+  }
+  self->_bufferedAmountLowThreshold.store(static_cast<uint64_t>(threshold), std::memory_order_relaxed);
+
+  TRACE_END;
+}
+
+NAN_GETTER(DataChannel::GetFraming) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(self->_framing));
+}
+
+NAN_SETTER(DataChannel::SetFraming) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+  self->_framing = value->BooleanValue();
+
+  TRACE_END;
+}
+
+NAN_GETTER(DataChannel::GetChunkEvents) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(self->_chunkEvents));
+}
+
+NAN_SETTER(DataChannel::SetChunkEvents) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+  self->_chunkEvents = value->BooleanValue();
+
+  TRACE_END;
+}
+
+NAN_GETTER(DataChannel::GetReceiveTimestamps) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(self->_receiveTimestamps));
+}
+
+NAN_SETTER(DataChannel::SetReceiveTimestamps) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+  self->_receiveTimestamps = value->BooleanValue();
+
+  TRACE_END;
+}
+
+NAN_GETTER(DataChannel::GetMaxChunkSize) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::New<Number>(static_cast<double>(self->_maxChunkSize)));
+}
+
+NAN_SETTER(DataChannel::SetMaxChunkSize) {
+  TRACE_CALL;
+
+  DataChannel* self = Nan::ObjectWrap::Unwrap<DataChannel>(info.Holder());
+  uint32_t size = value->Uint32Value();
+  if (size < kMinMaxChunkSize) {
+    return Nan::ThrowRangeError("maxChunkSize must be at least 64 bytes");
+  }
+  self->_maxChunkSize = size;
+
+  TRACE_END;
+}
+
+NAN_GETTER(DataChannel::GetCallback) {
+  Local<Array> callbacks = info.Holder()->GetInternalField(kCallbacksField).As<Array>();
+  Local<Value> callback = callbacks->Get(info.Data()->Uint32Value());
+
+  if (callback->IsFunction()) {
+    info.GetReturnValue().Set(callback);
+  } else {
+    info.GetReturnValue().Set(Nan::Null());
+  }
+}
+
+NAN_SETTER(DataChannel::SetCallback) {
+  Local<Array> callbacks = info.Holder()->GetInternalField(kCallbacksField).As<Array>();
+
+  if (value->IsFunction()) {
+    callbacks->Set(info.Data()->Uint32Value(), value);
+  } else {
+    callbacks->Set(info.Data()->Uint32Value(), Nan::Undefined());
+  }
+}
+
 NAN_SETTER(DataChannel::ReadOnly) {
   INFO("PeerConnection::ReadOnly");
 }
@@ -350,18 +1171,40 @@ NAN_SETTER(DataChannel::ReadOnly) {
 void DataChannel::Init(Handle<Object> exports) {
   Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
   tpl->SetClassName(Nan::New("DataChannel").ToLocalChecked());
-  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+  tpl->InstanceTemplate()->SetInternalFieldCount(kCallbacksField + 1);
 
   Nan::SetPrototypeMethod(tpl, "close", Close);
   Nan::SetPrototypeMethod(tpl, "shutdown", Shutdown);
   Nan::SetPrototypeMethod(tpl, "send", Send);
+  Nan::SetPrototypeMethod(tpl, "sendMany", SendMany);
+  Nan::SetPrototypeMethod(tpl, "pause", Pause);
+  Nan::SetPrototypeMethod(tpl, "resume", Resume);
+  Nan::SetPrototypeMethod(tpl, "setReceiveRing", SetReceiveRing);
+  Nan::SetPrototypeMethod(tpl, "getMetrics", GetMetrics);
+  Nan::SetPrototypeMethod(tpl, "getLatency", GetLatency);
 
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("bufferedAmount").ToLocalChecked(), GetBufferedAmount, ReadOnly);
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("label").ToLocalChecked(), GetLabel, ReadOnly);
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("binaryType").ToLocalChecked(), GetBinaryType, SetBinaryType);
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("readyState").ToLocalChecked(), GetReadyState, ReadOnly);
-
-  constructor.Reset(tpl->GetFunction());
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("batchMessages").ToLocalChecked(), GetBatchMessages, SetBatchMessages);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("bufferedAmountLowThreshold").ToLocalChecked(), GetBufferedAmountLowThreshold, SetBufferedAmountLowThreshold);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("framing").ToLocalChecked(), GetFraming, SetFraming);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("chunkEvents").ToLocalChecked(), GetChunkEvents, SetChunkEvents);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("receiveTimestamps").ToLocalChecked(), GetReceiveTimestamps, SetReceiveTimestamps);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("maxChunkSize").ToLocalChecked(), GetMaxChunkSize, SetMaxChunkSize);
+
+  // Event handlers are stored natively, as in PeerConnection::Init.
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onerror").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_ERROR));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onstatechange").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_STATE_CHANGE));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onmessage").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_MESSAGE));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onmessages").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_MESSAGES));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onbufferedamountlow").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_BUFFERED_AMOUNT_LOW));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onchunk").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_CHUNK));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onringdata").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_RING_DATA));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onringfull").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_RING_FULL));
+
+  IsolateState::Current()->dataChannelConstructor.Reset(tpl->GetFunction());
   exports->Set(Nan::New("DataChannel").ToLocalChecked(), tpl->GetFunction());
 
 #if NODE_MODULE_VERSION < 0x000C
@@ -3,8 +3,10 @@
 
 #include <string.h>
 
+#include <atomic>
+#include <memory>
 #include <string>
-#include <queue>
+#include <vector>
 
 #include "nan.h"
 #include "uv.h"
@@ -13,38 +15,64 @@
 #include "talk/app/webrtc/datachannelinterface.h"
 #include "webrtc/base/buffer.h"
 #include "webrtc/base/scoped_ref_ptr.h"
+#include "webrtc/base/thread.h"
+
+#include "async-dispatcher.h"
+#include "buffer-pool.h"
+#include "event-payload.h"
+#include "event-queue.h"
+#include "isolate-state.h"
+#include "latency-histogram.h"
+#include "metrics.h"
+#include "receive-ring.h"
 
 namespace node_webrtc {
 
 class DataChannelObserver;
+class PeerConnectionFactory;
 
 class DataChannel
 : public Nan::ObjectWrap
+, public AsyncDispatcher::Target
+, public IsolateState::Resource
 , public webrtc::DataChannelObserver {
   friend class node_webrtc::DataChannelObserver;
 
  public:
-  struct ErrorEvent {
+  struct ErrorEvent : public EventPayload {
     explicit ErrorEvent(const std::string& msg)
-    : msg(msg) {}
+    : msg(msg) {
+      Account(msg.size());
+    }
 
     std::string msg;
   };
 
   struct MessageEvent {
-    explicit MessageEvent(const webrtc::DataBuffer* buffer) {
-      binary = buffer->binary;
-      size = buffer->size();
-      message = new char[size];
-      memcpy(static_cast<void*>(message), static_cast<const void*>(buffer->data.data()), size);
-    }
+    // The payload is stored directly after the event in a single pooled
+    // allocation. Ownership of that allocation moves to V8 when a binary
+    // message is delivered; Release() returns it to the BufferPool. Message
+    // events are counted in EventPayload's stats until released.
+    static MessageEvent* Create(const webrtc::DataBuffer* buffer);
+    static MessageEvent* Allocate(bool binary, size_t size);
+    static void Release(MessageEvent* event);
 
     bool binary;
     char* message;
     size_t size;
+
+    // For CHUNK events: whether this is the final chunk of its message.
+    bool last;
+
+    // Weak handle to the ArrayBuffer wrapping |message|, if any.
+    Nan::Persistent<v8::Object> array;
+
+   private:
+    MessageEvent(bool binary, size_t size)
+    : binary(binary), message(reinterpret_cast<char*>(this + 1)), size(size), last(true) {}
   };
 
-  struct StateEvent {
+  struct StateEvent : public EventPayload {
     explicit StateEvent(const webrtc::DataChannelInterface::DataState state)
     : state(state) {}
 
@@ -55,11 +83,28 @@ class DataChannel
     MESSAGE = 0x1 << 0,  // 1
     ERROR = 0x1 << 1,  // 2
     STATE = 0x1 << 2,  // 4
+    BUFFERED_AMOUNT_LOW = 0x1 << 3,  // 8
+    CHUNK = 0x1 << 4,  // 16
+    RING_DATA = 0x1 << 5,  // 32
+    RING_FULL = 0x1 << 6,  // 64
   };
 
   enum BinaryType {
     BLOB = 0x0,
-    ARRAY_BUFFER = 0x1
+    ARRAY_BUFFER = 0x1,
+    NODE_BUFFER = 0x2
+  };
+
+  enum Callback {
+    ON_ERROR,
+    ON_STATE_CHANGE,
+    ON_MESSAGE,
+    ON_MESSAGES,
+    ON_BUFFERED_AMOUNT_LOW,
+    ON_CHUNK,
+    ON_RING_DATA,
+    ON_RING_FULL,
+    CALLBACK_COUNT
   };
 
   explicit DataChannel(node_webrtc::DataChannelObserver* observer);
@@ -71,42 +116,149 @@ class DataChannel
 
   virtual void OnStateChange();
   virtual void OnMessage(const webrtc::DataBuffer& buffer);
+  virtual void OnBufferedAmountChange(uint64_t previous_amount);
 
   //
   // Nodejs wrapping.
   //
   static void Init(v8::Handle<v8::Object> exports);
-  static Nan::Persistent<v8::Function> constructor;
   static NAN_METHOD(New);
 
   static NAN_METHOD(Send);
+  static NAN_METHOD(SendMany);
   static NAN_METHOD(Close);
   static NAN_METHOD(Shutdown);
+  static NAN_METHOD(Pause);
+  static NAN_METHOD(Resume);
+  static NAN_METHOD(SetReceiveRing);
+  static NAN_METHOD(GetMetrics);
+  static NAN_METHOD(GetLatency);
 
   static NAN_GETTER(GetBufferedAmount);
   static NAN_GETTER(GetLabel);
   static NAN_GETTER(GetBinaryType);
   static NAN_GETTER(GetReadyState);
   static NAN_SETTER(SetBinaryType);
+  static NAN_GETTER(GetBatchMessages);
+  static NAN_SETTER(SetBatchMessages);
+  static NAN_GETTER(GetBufferedAmountLowThreshold);
+  static NAN_SETTER(SetBufferedAmountLowThreshold);
+  static NAN_GETTER(GetFraming);
+  static NAN_SETTER(SetFraming);
+  static NAN_GETTER(GetChunkEvents);
+  static NAN_SETTER(SetChunkEvents);
+  static NAN_GETTER(GetMaxChunkSize);
+  static NAN_SETTER(SetMaxChunkSize);
+  static NAN_GETTER(GetReceiveTimestamps);
+  static NAN_SETTER(SetReceiveTimestamps);
+  static NAN_GETTER(GetCallback);
+  static NAN_SETTER(SetCallback);
   static NAN_SETTER(ReadOnly);
 
+  // Takes ownership of |data|: a MessageEvent for MESSAGE and CHUNK, an
+  // EventPayload for ERROR and STATE, and null otherwise.
   void QueueEvent(DataChannel::AsyncEventType type, void* data);
 
  private:
-  static void Run(uv_async_t* handle, int status);
+  // Queues |evt| with the queuedAt it already carries.
+  void QueueEvent(const AsyncEvent& evt);
+
+  virtual void Run();
+  void Stop();
+
+  // Unregisters from libwebrtc, frees queued events and drops the factory
+  // reference. Called by the destructor, or by IsolateState when the worker
+  // exits first.
+  virtual void Teardown();
+
+  // Internal field holding the on* handlers, as in
+  // PeerConnection::kCallbacksField.
+  static const int kCallbacksField = 1;
+
+  v8::Local<v8::Array> Callbacks();
+  void Emit(v8::Local<v8::Array> callbacks, Callback callback, int argc, v8::Local<v8::Value> argv[]);
+  static v8::Local<v8::Value> CreateMessage(MessageEvent* data, BinaryType binaryType);
+  static bool ToDataBuffer(v8::Local<v8::Value> value, webrtc::DataBuffer* data_buffer);
+
+  // Sends |buffers| in order, stopping at the first one the channel refuses,
+  // and returns how many were sent. Frames are not messages, so the callers
+  // count what they sent with CountSent().
+  uint32_t SendBuffers(const std::vector<webrtc::DataBuffer>& buffers);
+  void CountSent(const std::vector<webrtc::DataBuffer>& messages, uint32_t count);
+  void OnFrame(const webrtc::DataBuffer& buffer);
+  void ResetFrame();
+  // Reports a broken framed message. Any frames still to come for it are
+  // dropped, up to the first frame of the next message.
+  void FrameError(const char* msg);
+  bool WriteToRing(const webrtc::DataBuffer& buffer);
 
   struct AsyncEvent {
     AsyncEventType type;
     void* data;
+    uint64_t queuedAt;  // uv_hrtime() when queued
   };
 
-  uv_mutex_t lock;
-  uv_async_t async;
-  uv_loop_t *loop;
-  std::queue<AsyncEvent> _events;
+  // Frees the payload of an event that will not be handled.
+  static void ReleaseEvent(const AsyncEvent& event);
+
+  IsolateState* _state;
+  AsyncDispatcher* _dispatcher;
+  Metrics _metrics;
+  bool _shutdown;
+  EventQueue<AsyncEvent> _events;
+  std::vector<AsyncEvent> _batch;
 
   rtc::scoped_refptr<webrtc::DataChannelInterface> _jingleDataChannel;
+  // Referenced so that the signaling thread outlives this channel, even
+  // once its PeerConnection is gone.
+  PeerConnectionFactory* _factory;
+  rtc::Thread* _signalingThread;
   BinaryType _binaryType;
+  bool _batchMessages;
+
+  // Written on the Node thread, read on the signaling thread whenever the
+  // send buffer drains.
+  std::atomic<uint64_t> _bufferedAmountLowThreshold;
+
+  // Opt-in framing: outgoing messages are split into chunks of at most
+  // _maxChunkSize bytes, each with a small header, and incoming chunks are
+  // reassembled on the signaling thread. Both peers must enable it, and the
+  // channel must be ordered and reliable.
+  std::atomic<bool> _framing;
+  std::atomic<bool> _chunkEvents;
+  size_t _maxChunkSize;
+
+  // Reassembly state, only touched on the signaling thread. |_partial| is
+  // null while chunks are being forwarded as CHUNK events.
+  bool _inFrame;
+  bool _frameResync;
+  MessageEvent* _partial;
+  size_t _frameLength;
+  size_t _frameOffset;
+
+  // Receive ring. While set, unframed messages are written straight into the
+  // caller's SharedArrayBuffer on the signaling thread instead of being
+  // queued. _ringLock guards _ring against setReceiveRing() on the Node
+  // thread; the backing memory is pinned by _ringBuffer.
+  uv_mutex_t _ringLock;
+  ReceiveRing* _ring;
+  bool _ringOverflow;
+  Nan::Persistent<v8::Object> _ringBuffer;
+
+  // How long events wait between being queued and being handled in Run().
+  // With _receiveTimestamps set, onmessage also gets the time each message
+  // was queued.
+  LatencyHistogram _latency;
+  bool _receiveTimestamps;
+
+  // Set by pause(); Run() leaves events queued until resume(). Read on the
+  // signaling thread to cap what a paused channel holds: once _queuedBytes
+  // of undelivered messages would pass the cap, further messages are dropped
+  // and a single error is queued until the next resume().
+  std::atomic<bool> _paused;
+  std::atomic<bool> _pauseOverflow;
+  std::atomic<uint64_t> _queuedBytes;
+  std::vector<AsyncEvent>::size_type _batchPos;
 
 #if NODE_MODULE_VERSION < 0x000C
   static Nan::Persistent<v8::Function> ArrayBufferConstructor;
@@ -117,16 +269,25 @@ class DataChannel
 class DataChannelObserver
 : public webrtc::DataChannelObserver {
  public:
-  explicit DataChannelObserver(rtc::scoped_refptr<webrtc::DataChannelInterface> jingleDataChannel);
+  DataChannelObserver(rtc::scoped_refptr<webrtc::DataChannelInterface> jingleDataChannel,
+                      PeerConnectionFactory* factory,
+                      std::shared_ptr<Metrics> parentMetrics);
   virtual ~DataChannelObserver();
 
   virtual void OnStateChange();
   virtual void OnMessage(const webrtc::DataBuffer& buffer);
   void QueueEvent(DataChannel::AsyncEventType type, void* data);
 
-  uv_mutex_t lock;
-  std::queue<DataChannel::AsyncEvent> _events;
+  EventQueue<DataChannel::AsyncEvent> _events;
   rtc::scoped_refptr<webrtc::DataChannelInterface> _jingleDataChannel;
+  PeerConnectionFactory* _factory;
+  std::shared_ptr<Metrics> _parentMetrics;
+
+  // Messages cached before adoption, added to the DataChannel's metrics when
+  // it takes over. Written on the signaling thread; read once the channel
+  // has replaced this observer, which waits on that thread.
+  uint64_t _messagesReceived;
+  uint64_t _bytesReceived;
 };
 
 }  // namespace node_webrtc
@@ -0,0 +1,76 @@
+#include "event-payload.h"
+
+#include <atomic>
+
+#include "buffer-pool.h"
+#include "common.h"
+
+using node_webrtc::EventPayload;
+using v8::FunctionTemplate;
+using v8::Handle;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+
+static std::atomic<uint64_t> liveEvents(0);
+static std::atomic<uint64_t> liveBytes(0);
+static std::atomic<uint64_t> created(0);
+
+EventPayload::EventPayload()
+: _bytes(0) {
+  Track(0);
+}
+
+EventPayload::~EventPayload() {
+  Untrack(_bytes);
+}
+
+void* EventPayload::operator new(size_t size) {
+  liveBytes += size;
+  return BufferPool::Allocate(size);
+}
+
+void EventPayload::operator delete(void* block, size_t size) {
+  liveBytes -= size;
+  BufferPool::Free(block);
+}
+
+void EventPayload::Track(size_t bytes) {
+  liveEvents++;
+  liveBytes += bytes;
+  created++;
+}
+
+void EventPayload::Untrack(size_t bytes) {
+  liveEvents--;
+  liveBytes -= bytes;
+}
+
+void EventPayload::Account(size_t bytes) {
+  _bytes += bytes;
+  liveBytes += bytes;
+}
+
+EventPayload::Stats EventPayload::Snapshot() {
+  Stats stats = { liveEvents.load(), liveBytes.load(), created.load() };
+  return stats;
+}
+
+NAN_METHOD(EventPayload::GetStats) {
+  TRACE_CALL;
+
+  Stats stats = Snapshot();
+
+  Local<Object> result = Nan::New<Object>();
+  result->Set(Nan::New("liveEvents").ToLocalChecked(), Nan::New<Number>(stats.liveEvents));
+  result->Set(Nan::New("liveBytes").ToLocalChecked(), Nan::New<Number>(stats.liveBytes));
+  result->Set(Nan::New("created").ToLocalChecked(), Nan::New<Number>(stats.created));
+
+  TRACE_END;
+  info.GetReturnValue().Set(result);
+}
+
+void EventPayload::Init(Handle<Object> exports) {
+  exports->Set(Nan::New("getEventStats").ToLocalChecked(),
+      Nan::New<FunctionTemplate>(GetStats)->GetFunction());
+}
@@ -0,0 +1,59 @@
+#ifndef SRC_EVENT_PAYLOAD_H_
+#define SRC_EVENT_PAYLOAD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nan.h"
+#include "v8.h"  // IWYU pragma: keep
+
+namespace node_webrtc {
+
+//
+// Base of the payloads carried by queued events. A payload is owned by the
+// event that carries it and is deleted once that event has been handled, or
+// when its target goes away with the event still queued.
+//
+// Every payload is counted process-wide, together with the bytes it holds,
+// so that growth in the event pipeline shows up in getEventStats().
+//
+class EventPayload {
+ public:
+  struct Stats {
+    uint64_t liveEvents;  // payloads created and not yet freed
+    uint64_t liveBytes;   // bytes held by those payloads
+    uint64_t created;     // payloads created since startup
+  };
+
+  EventPayload();
+  virtual ~EventPayload();
+
+  static void* operator new(size_t size);
+  static void operator delete(void* block, size_t size);
+
+  // For payloads that live outside operator new, such as message events.
+  static void Track(size_t bytes);
+  static void Untrack(size_t bytes);
+
+  static Stats Snapshot();
+
+  //
+  // Nodejs wrapping.
+  //
+  static void Init(v8::Handle<v8::Object> exports);
+  static NAN_METHOD(GetStats);
+
+ protected:
+  // Adds out-of-line data, such as string contents, to the live byte count.
+  void Account(size_t bytes);
+
+ private:
+  EventPayload(const EventPayload&);
+  EventPayload& operator=(const EventPayload&);
+
+  size_t _bytes;
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_EVENT_PAYLOAD_H_
@@ -0,0 +1,60 @@
+#ifndef SRC_EVENT_QUEUE_H_
+#define SRC_EVENT_QUEUE_H_
+
+#include <vector>
+
+#include "uv.h"
+
+namespace node_webrtc {
+
+//
+// Multi-producer, single-consumer event queue. libwebrtc threads Push() one
+// event at a time; the Node thread takes everything queued so far with a
+// single Swap(), so the lock is held once per wakeup instead of once per event.
+//
+template <typename T>
+class EventQueue {
+ public:
+  EventQueue() {
+    uv_mutex_init(&_lock);
+  }
+
+  ~EventQueue() {
+    uv_mutex_destroy(&_lock);
+  }
+
+  // Returns true if the queue was empty before |event| was added.
+  bool Push(const T& event) {
+    uv_mutex_lock(&_lock);
+    bool was_empty = _events.empty();
+    _events.push_back(event);
+    uv_mutex_unlock(&_lock);
+    return was_empty;
+  }
+
+  // Exchanges the queued events with |batch|, which the caller should have
+  // cleared. Handing back a cleared vector lets both sides reuse capacity.
+  void Swap(std::vector<T>* batch) {
+    uv_mutex_lock(&_lock);
+    _events.swap(*batch);
+    uv_mutex_unlock(&_lock);
+  }
+
+  bool Empty() {
+    uv_mutex_lock(&_lock);
+    bool empty = _events.empty();
+    uv_mutex_unlock(&_lock);
+    return empty;
+  }
+
+ private:
+  EventQueue(const EventQueue&);
+  EventQueue& operator=(const EventQueue&);
+
+  uv_mutex_t _lock;
+  std::vector<T> _events;
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_EVENT_QUEUE_H_
@@ -0,0 +1,93 @@
+#include "isolate-state.h"
+
+#include <vector>
+
+#include "node.h"
+
+#include "common.h"
+#include "log-sink.h"
+
+using node_webrtc::IsolateState;
+using v8::Isolate;
+
+uv_once_t IsolateState::_once = UV_ONCE_INIT;
+uv_mutex_t IsolateState::_lock;
+std::map<Isolate*, IsolateState*>* IsolateState::_states;
+
+IsolateState::IsolateState(Isolate* isolate, uv_loop_t* loop)
+: _isolate(isolate),
+  _dispatcher(new AsyncDispatcher(loop)) {
+}
+
+IsolateState::~IsolateState() {
+  peerConnectionConstructor.Reset();
+  peerConnectionTemplate.Reset();
+  dataChannelConstructor.Reset();
+  statsReportConstructor.Reset();
+  statsResponseConstructor.Reset();
+  LogSink::OnIsolateCleanup(_isolate);
+
+  // The dispatcher itself outlives the state: libwebrtc threads may still
+  // schedule leftover objects on it, which Close() turns into no-ops.
+  _dispatcher->Close();
+}
+
+void IsolateState::InitStates() {
+  uv_mutex_init(&_lock);
+  _states = new std::map<Isolate*, IsolateState*>();
+}
+
+IsolateState* IsolateState::Create() {
+  TRACE_CALL;
+  uv_once(&_once, InitStates);
+
+  Isolate* isolate = Isolate::GetCurrent();
+
+  uv_mutex_lock(&_lock);
+  IsolateState*& state = (*_states)[isolate];
+  bool created = !state;
+  if (created) {
+    state = new IsolateState(isolate, Nan::GetCurrentEventLoop());
+  }
+  uv_mutex_unlock(&_lock);
+
+#if NODE_MODULE_VERSION >= 64
+  if (created) {
+    node::AddEnvironmentCleanupHook(isolate, Cleanup, state);
+  }
+#endif
+
+  TRACE_END;
+  return state;
+}
+
+IsolateState* IsolateState::Current() {
+  Isolate* isolate = Isolate::GetCurrent();
+
+  uv_mutex_lock(&_lock);
+  std::map<Isolate*, IsolateState*>::iterator it = _states->find(isolate);
+  IsolateState* state = it != _states->end() ? it->second : nullptr;
+  uv_mutex_unlock(&_lock);
+
+  return state;
+}
+
+void IsolateState::Cleanup(void* arg) {
+  TRACE_CALL;
+  IsolateState* state = static_cast<IsolateState*>(arg);
+
+  uv_mutex_lock(&_lock);
+  _states->erase(state->_isolate);
+  uv_mutex_unlock(&_lock);
+
+  // Close every connection and channel the worker left open, so libwebrtc
+  // stops delivering into queues that nothing drains any more.
+  std::vector<Resource*> resources(state->_resources.begin(), state->_resources.end());
+  state->_resources.clear();
+  for (std::vector<Resource*>::size_type i = 0; i < resources.size(); i++) {
+    resources[i]->Teardown();
+  }
+
+  delete state;
+  TRACE_END;
+}
@@ -0,0 +1,73 @@
+#ifndef SRC_ISOLATE_STATE_H_
+#define SRC_ISOLATE_STATE_H_
+
+#include <map>
+#include <unordered_set>
+
+#include "nan.h"
+#include "uv.h"
+#include "v8.h"  // IWYU pragma: keep
+
+#include "async-dispatcher.h"
+
+namespace node_webrtc {
+
+//
+// Everything the addon keeps per V8 isolate: the constructors of the wrapped
+// classes and the dispatcher bound to the isolate's event loop. The main
+// thread and every worker_thread that loads the addon get their own state,
+// which is torn down by an environment cleanup hook when the worker exits.
+//
+class IsolateState {
+ public:
+  //
+  // A native object that holds libwebrtc resources for JS in this isolate.
+  // When a worker exits its wrappers are never collected, so the cleanup
+  // hook calls Teardown() on every resource still registered. Teardown()
+  // must leave the object safe to destroy later, and must not touch the
+  // state again.
+  //
+  class Resource {
+   public:
+    virtual ~Resource() {}
+    virtual void Teardown() = 0;
+  };
+
+  // Creates the state for the calling isolate, or returns the existing one
+  // if the addon is loaded into several contexts of the same isolate.
+  static IsolateState* Create();
+
+  // The state of the calling isolate. Must be called on a JS thread.
+  static IsolateState* Current();
+
+  AsyncDispatcher* dispatcher() { return _dispatcher; }
+
+  // Node thread only.
+  void AddResource(Resource* resource) { _resources.insert(resource); }
+  void RemoveResource(Resource* resource) { _resources.erase(resource); }
+
+  Nan::Persistent<v8::Function> peerConnectionConstructor;
+  Nan::Persistent<v8::FunctionTemplate> peerConnectionTemplate;
+  Nan::Persistent<v8::Function> dataChannelConstructor;
+  Nan::Persistent<v8::Function> statsReportConstructor;
+  Nan::Persistent<v8::Function> statsResponseConstructor;
+
+ private:
+  IsolateState(v8::Isolate* isolate, uv_loop_t* loop);
+  ~IsolateState();
+
+  static void InitStates();
+  static void Cleanup(void* arg);
+
+  v8::Isolate* _isolate;
+  AsyncDispatcher* _dispatcher;
+  std::unordered_set<Resource*> _resources;
+
+  static uv_once_t _once;
+  static uv_mutex_t _lock;
+  static std::map<v8::Isolate*, IsolateState*>* _states;
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_ISOLATE_STATE_H_
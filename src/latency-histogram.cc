@@ -0,0 +1,97 @@
+#include "latency-histogram.h"
+
+#include <string.h>
+
+#include <cmath>
+
+#include "common.h"
+
+using node_webrtc::LatencyHistogram;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+
+LatencyHistogram::LatencyHistogram() {
+  Reset();
+}
+
+void LatencyHistogram::Reset() {
+  memset(_counts, 0, sizeof(_counts));
+  _count = 0;
+  _min = 0;
+  _max = 0;
+  _sum = 0;
+}
+
+//
+// Values below kSubBuckets get a bucket each. Above that, a value whose
+// highest set bit is b lands in level (b - kSubBucketBits + 1), and its next
+// kSubBucketBits - 1 bits pick one of the level's kSubBuckets / 2 buckets.
+//
+uint32_t LatencyHistogram::IndexOf(uint64_t value) {
+  if (value < kSubBuckets) {
+    return static_cast<uint32_t>(value);
+  }
+  uint32_t msb = 63 - __builtin_clzll(value);
+  uint32_t level = msb - kSubBucketBits + 1;
+  uint32_t sub = static_cast<uint32_t>(value >> level) - kSubBuckets / 2;
+  return kSubBuckets + (level - 1) * (kSubBuckets / 2) + sub;
+}
+
+// The midpoint of the values that map to |index|.
+uint64_t LatencyHistogram::ValueAt(uint32_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  uint32_t level = (index - kSubBuckets) / (kSubBuckets / 2) + 1;
+  uint64_t sub = (index - kSubBuckets) % (kSubBuckets / 2) + kSubBuckets / 2;
+  uint64_t lowest = sub << level;
+  return lowest + ((static_cast<uint64_t>(1) << level) >> 1);
+}
+
+void LatencyHistogram::Record(uint64_t value) {
+  if (value > kMaxValue) {
+    value = kMaxValue;
+  }
+  _counts[IndexOf(value)]++;
+  if (0 == _count || value < _min) {
+    _min = value;
+  }
+  if (value > _max) {
+    _max = value;
+  }
+  _count++;
+  _sum += value;
+}
+
+uint64_t LatencyHistogram::Percentile(double percentile) const {
+  if (0 == _count) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100 * _count));
+  if (rank < 1) {
+    rank = 1;
+  }
+
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < kBucketCount; i++) {
+    seen += _counts[i];
+    if (seen >= rank) {
+      uint64_t value = ValueAt(i);
+      return value < _min ? _min : value > _max ? _max : value;
+    }
+  }
+  return _max;
+}
+
+Local<Object> LatencyHistogram::ToObject() const {
+  Local<Object> result = Nan::New<Object>();
+  result->Set(Nan::New("count").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_count)));
+  result->Set(Nan::New("min").ToLocalChecked(), Nan::New<Number>(_min / 1e3));
+  result->Set(Nan::New("max").ToLocalChecked(), Nan::New<Number>(_max / 1e3));
+  result->Set(Nan::New("mean").ToLocalChecked(), Nan::New<Number>(_count ? _sum / _count / 1e3 : 0));
+  result->Set(Nan::New("p50").ToLocalChecked(), Nan::New<Number>(Percentile(50) / 1e3));
+  result->Set(Nan::New("p99").ToLocalChecked(), Nan::New<Number>(Percentile(99) / 1e3));
+  result->Set(Nan::New("p999").ToLocalChecked(), Nan::New<Number>(Percentile(99.9) / 1e3));
+  return result;
+}
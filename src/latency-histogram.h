@@ -0,0 +1,53 @@
+#ifndef SRC_LATENCY_HISTOGRAM_H_
+#define SRC_LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+
+#include "nan.h"
+#include "v8.h"  // IWYU pragma: keep
+
+namespace node_webrtc {
+
+//
+// Log-linear histogram of nanosecond durations in the style of
+// HdrHistogram: every power of two above kSubBuckets is split into
+// kSubBuckets / 2 linear buckets, so a recorded value is reported within
+// 1/64 of its true value. Values above kMaxValue are clamped to it.
+//
+// Not thread-safe; a DataChannel records into its histogram only on the
+// Node thread.
+//
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  void Record(uint64_t value);
+  void Reset();
+
+  uint64_t Count() const { return _count; }
+  uint64_t Percentile(double percentile) const;
+
+  // { count, min, max, mean, p50, p99, p999 }, durations in microseconds.
+  v8::Local<v8::Object> ToObject() const;
+
+ private:
+  static const uint32_t kSubBucketBits = 6;
+  static const uint32_t kSubBuckets = 1 << kSubBucketBits;
+  static const uint32_t kMaxValueBits = 36;  // ~68.7s
+  static const uint64_t kMaxValue = (static_cast<uint64_t>(1) << kMaxValueBits) - 1;
+  static const uint32_t kBucketCount =
+      kSubBuckets + (kMaxValueBits - kSubBucketBits) * (kSubBuckets / 2);
+
+  static uint32_t IndexOf(uint64_t value);
+  static uint64_t ValueAt(uint32_t index);
+
+  uint64_t _counts[kBucketCount];
+  uint64_t _count;
+  uint64_t _min;
+  uint64_t _max;
+  double _sum;
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_LATENCY_HISTOGRAM_H_
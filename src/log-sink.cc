@@ -0,0 +1,246 @@
+#include "log-sink.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "buffer-pool.h"
+#include "isolate-state.h"
+
+using node_webrtc::AsyncDispatcher;
+using node_webrtc::BufferPool;
+using node_webrtc::IsolateState;
+using node_webrtc::LogSink;
+using v8::Array;
+using v8::Function;
+using v8::FunctionTemplate;
+using v8::Handle;
+using v8::Isolate;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+using v8::String;
+using v8::Value;
+
+// Lines from libwebrtc carry no severity of their own; the sink only
+// receives those at or above its threshold.
+static const int kWebRtcLine = -1;
+
+static const char* kSeverityNames[] = { "verbose", "info", "warning", "error" };
+
+static const char* kStdoutFormats[] = {
+  " native:%s\n",
+  "\033[01;34m native:%s \033[00m\n",
+  "\033[01;33m native:%s \033[00m\n",
+  "\033[01;32m native:%s \033[00m\n"
+};
+
+static const rtc::LoggingSeverity kRtcSeverities[] = {
+  rtc::LS_VERBOSE, rtc::LS_INFO, rtc::LS_WARNING, rtc::LS_ERROR
+};
+
+struct LogSink::Line {
+  Line* next;
+  int severity;
+  size_t length;
+
+  char* text() { return reinterpret_cast<char*>(this + 1); }
+};
+
+uv_once_t LogSink::_once = UV_ONCE_INIT;
+LogSink* LogSink::_instance;
+
+LogSink::LogSink()
+: _head(nullptr),
+  _pending(0),
+  _dropped(0),
+  _threshold(SEVERITY_INFO),
+  _dispatcher(nullptr),
+  _isolate(nullptr) {
+}
+
+void LogSink::CreateInstance() {
+  // Never destroyed: libwebrtc threads may log until the process exits.
+  _instance = new LogSink();
+}
+
+LogSink* LogSink::Instance() {
+  uv_once(&_once, CreateInstance);
+  return _instance;
+}
+
+void LogSink::Log(Severity severity, const char* message) {
+  LogSink* self = Instance();
+  if (severity < self->_threshold.load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (self->_dispatcher.load(std::memory_order_acquire)) {
+    self->Push(severity, message, strlen(message));
+  } else {
+    fprintf(stdout, kStdoutFormats[severity], message);
+  }
+}
+
+void LogSink::OnLogMessage(const std::string& message) {
+  size_t length = message.size();
+  if (length && '\n' == message[length - 1]) {
+    length--;
+  }
+  Push(kWebRtcLine, message.data(), length);
+}
+
+void LogSink::Push(int severity, const char* message, size_t length) {
+  if (_pending.fetch_add(1, std::memory_order_relaxed) >= kMaxPending) {
+    _pending.fetch_sub(1, std::memory_order_relaxed);
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Line* line = static_cast<Line*>(BufferPool::Allocate(sizeof(Line) + length));
+  line->severity = severity;
+  line->length = length;
+  memcpy(line->text(), message, length);
+
+  Line* head = _head.load(std::memory_order_relaxed);
+  do {
+    line->next = head;
+  } while (!_head.compare_exchange_weak(head, line, std::memory_order_release, std::memory_order_relaxed));
+
+  // A non-empty stack means a wakeup is already pending.
+  AsyncDispatcher* dispatcher = _dispatcher.load(std::memory_order_acquire);
+  if (!head && dispatcher) {
+    dispatcher->Schedule(this);
+  }
+}
+
+void LogSink::Attach(Local<Function> callback) {
+  _callback.Reset(callback);
+  if (!_dispatcher.load(std::memory_order_relaxed)) {
+    _isolate = Isolate::GetCurrent();
+    _dispatcher.store(IsolateState::Current()->dispatcher(), std::memory_order_release);
+    rtc::LogMessage::AddLogToStream(this, kRtcSeverities[_threshold.load()]);
+  }
+
+  // Lines left over from an earlier callback have no wakeup pending.
+  if (_head.load(std::memory_order_acquire)) {
+    _dispatcher.load(std::memory_order_relaxed)->Schedule(this);
+  }
+}
+
+void LogSink::Detach() {
+  AsyncDispatcher* dispatcher = _dispatcher.load(std::memory_order_relaxed);
+  if (!dispatcher) {
+    return;
+  }
+  rtc::LogMessage::RemoveLogToStream(this);
+  _dispatcher.store(nullptr, std::memory_order_release);
+  dispatcher->Cancel(this);
+  _callback.Reset();
+  _isolate = nullptr;
+}
+
+void LogSink::OnIsolateCleanup(Isolate* isolate) {
+  LogSink* self = Instance();
+  if (self->_isolate == isolate) {
+    self->Detach();
+  }
+}
+
+void LogSink::Run() {
+  // A wakeup queued just before the callback moved to another isolate.
+  if (Isolate::GetCurrent() != _isolate || _callback.IsEmpty()) {
+    return;
+  }
+  Nan::HandleScope scope;
+
+  Line* line = _head.exchange(nullptr, std::memory_order_acquire);
+
+  // The stack is newest first.
+  Line* ordered = nullptr;
+  uint32_t count = 0;
+  while (line) {
+    Line* next = line->next;
+    line->next = ordered;
+    ordered = line;
+    line = next;
+    count++;
+  }
+  _pending.fetch_sub(count, std::memory_order_relaxed);
+
+  Local<Array> lines = Nan::New<Array>(count);
+  Local<String> source = Nan::New("source").ToLocalChecked();
+  Local<String> severity = Nan::New("severity").ToLocalChecked();
+  Local<String> message = Nan::New("message").ToLocalChecked();
+  for (uint32_t i = 0; ordered; i++) {
+    line = ordered;
+    ordered = line->next;
+
+    Local<Object> entry = Nan::New<Object>();
+    if (kWebRtcLine == line->severity) {
+      entry->Set(source, Nan::New("webrtc").ToLocalChecked());
+    } else {
+      entry->Set(source, Nan::New("native").ToLocalChecked());
+      entry->Set(severity, Nan::New(kSeverityNames[line->severity]).ToLocalChecked());
+    }
+    entry->Set(message, Nan::New(line->text(), line->length).ToLocalChecked());
+    lines->Set(i, entry);
+
+    BufferPool::Free(line);
+  }
+
+  uint64_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+  if (count || dropped) {
+    Local<Value> argv[2];
+    argv[0] = lines;
+    argv[1] = Nan::New<Number>(static_cast<double>(dropped));
+    _callback.Call(2, argv);
+  }
+}
+
+NAN_METHOD(LogSink::SetLogger) {
+  LogSink* self = Instance();
+
+  if (info[0]->IsFunction()) {
+    if (self->_isolate && self->_isolate != Isolate::GetCurrent()) {
+      return Nan::ThrowError("A logger is already installed by another thread");
+    }
+    self->Attach(info[0].As<Function>());
+  } else if (info[0]->IsNull() || info[0]->IsUndefined()) {
+    if (self->_isolate == Isolate::GetCurrent()) {
+      self->Detach();
+    }
+  } else {
+    return Nan::ThrowTypeError("Argument 0 must be a function or null");
+  }
+}
+
+NAN_METHOD(LogSink::SetLogSeverity) {
+  LogSink* self = Instance();
+
+  int severity = -1;
+  if (info[0]->IsString()) {
+    String::Utf8Value name(info[0]);
+    for (int i = SEVERITY_VERBOSE; i <= SEVERITY_ERROR; i++) {
+      if (0 == strcmp(*name, kSeverityNames[i])) {
+        severity = i;
+      }
+    }
+  }
+  if (severity < 0) {
+    return Nan::ThrowTypeError("Argument 0 must be 'verbose', 'info', 'warning' or 'error'");
+  }
+
+  self->_threshold.store(severity, std::memory_order_relaxed);
+  if (self->_isolate == Isolate::GetCurrent() && self->_dispatcher.load(std::memory_order_relaxed)) {
+    // Re-registering is how libwebrtc changes a stream's minimum severity.
+    rtc::LogMessage::RemoveLogToStream(self);
+    rtc::LogMessage::AddLogToStream(self, kRtcSeverities[severity]);
+  }
+}
+
+void LogSink::Init(Handle<Object> exports) {
+  Instance();
+  exports->Set(Nan::New("setLogger").ToLocalChecked(),
+      Nan::New<FunctionTemplate>(SetLogger)->GetFunction());
+  exports->Set(Nan::New("setLogSeverity").ToLocalChecked(),
+      Nan::New<FunctionTemplate>(SetLogSeverity)->GetFunction());
+}
@@ -0,0 +1,94 @@
+#ifndef SRC_LOG_SINK_H_
+#define SRC_LOG_SINK_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "nan.h"
+#include "uv.h"
+#include "v8.h"  // IWYU pragma: keep
+
+#include "webrtc/base/logging.h"
+
+#include "async-dispatcher.h"
+
+namespace node_webrtc {
+
+//
+// Collects libwebrtc's log output and the addon's own WARN/INFO/ERROR lines
+// and hands them to a JS callback installed with setLogger().
+//
+// Producers push onto a lock-free stack and schedule the sink on the
+// dispatcher of the isolate that installed the callback. That isolate then
+// drains the stack in one batch per wakeup. A libwebrtc thread therefore
+// never blocks on the Node thread or on stdout. At most kMaxPending lines
+// wait at a time; anything beyond that is dropped and counted.
+//
+// Lines below the severity set with setLogSeverity() are discarded where
+// they are produced. Without a callback, the addon's own lines go to stdout
+// as before and libwebrtc's are not collected at all.
+//
+class LogSink
+: public rtc::LogSink
+, public AsyncDispatcher::Target {
+ public:
+  enum Severity {
+    SEVERITY_VERBOSE,
+    SEVERITY_INFO,
+    SEVERITY_WARNING,
+    SEVERITY_ERROR
+  };
+
+  // For the WARN/INFO/ERROR macros. Safe from any thread.
+  static void Log(Severity severity, const char* message);
+
+  // Detaches the callback if it belongs to |isolate|, which is going away.
+  static void OnIsolateCleanup(v8::Isolate* isolate);
+
+  //
+  // rtc::LogSink implementation.
+  //
+  virtual void OnLogMessage(const std::string& message);
+
+  //
+  // Nodejs wrapping.
+  //
+  static void Init(v8::Handle<v8::Object> exports);
+  static NAN_METHOD(SetLogger);
+  static NAN_METHOD(SetLogSeverity);
+
+ private:
+  struct Line;
+
+  LogSink();
+
+  static LogSink* Instance();
+  static void CreateInstance();
+
+  void Push(int severity, const char* message, size_t length);
+  void Attach(v8::Local<v8::Function> callback);
+  void Detach();
+  virtual void Run();
+
+  static const uint32_t kMaxPending = 8192;
+
+  std::atomic<Line*> _head;
+  std::atomic<uint32_t> _pending;
+  std::atomic<uint64_t> _dropped;
+  std::atomic<int> _threshold;
+
+  // Non-null while a callback is installed. Written only on the installing
+  // isolate's thread.
+  std::atomic<AsyncDispatcher*> _dispatcher;
+  v8::Isolate* _isolate;
+  Nan::Callback _callback;
+
+  static uv_once_t _once;
+  static LogSink* _instance;
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_LOG_SINK_H_
@@ -0,0 +1,81 @@
+#include "metrics.h"
+
+#include "common.h"
+
+using node_webrtc::Metrics;
+using v8::FunctionTemplate;
+using v8::Handle;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+
+static const char* kCounterNames[] = {
+  "messagesSent",
+  "bytesSent",
+  "messagesReceived",
+  "bytesReceived",
+  "eventsQueued",
+  "eventsDrained",
+  "wakeups",
+  "drainTimeNs"
+};
+
+static_assert(sizeof(kCounterNames) / sizeof(kCounterNames[0]) == Metrics::COUNTER_COUNT,
+              "every counter needs a name");
+
+Metrics::Metrics(std::shared_ptr<Metrics> parent)
+: _parent(parent) {
+  for (int i = 0; i < COUNTER_COUNT; i++) {
+    _counters[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::AddLocal(Counter counter, uint64_t value) {
+  _counters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+void Metrics::Add(Counter counter, uint64_t value) {
+  AddLocal(counter, value);
+  if (_parent) {
+    _parent->AddLocal(counter, value);
+  }
+  Global()->AddLocal(counter, value);
+}
+
+uint64_t Metrics::Get(Counter counter) const {
+  return _counters[counter].load(std::memory_order_relaxed);
+}
+
+Local<Object> Metrics::ToObject() const {
+  Local<Object> result = Nan::New<Object>();
+  for (int i = 0; i < COUNTER_COUNT; i++) {
+    result->Set(Nan::New(kCounterNames[i]).ToLocalChecked(),
+        Nan::New<Number>(static_cast<double>(Get(static_cast<Counter>(i)))));
+  }
+
+  // Queued and drained are read separately, so clamp a momentarily
+  // inconsistent pair rather than report a negative depth.
+  uint64_t queued = Get(EVENTS_QUEUED);
+  uint64_t drained = Get(EVENTS_DRAINED);
+  result->Set(Nan::New("queueDepth").ToLocalChecked(),
+      Nan::New<Number>(queued > drained ? static_cast<double>(queued - drained) : 0));
+  return result;
+}
+
+Metrics* Metrics::Global() {
+  // Shared by every isolate and never destroyed, so libwebrtc threads can
+  // still update it while the process exits.
+  static Metrics* global = new Metrics();
+  return global;
+}
+
+NAN_METHOD(Metrics::GetMetrics) {
+  TRACE_CALL;
+  TRACE_END;
+  info.GetReturnValue().Set(Global()->ToObject());
+}
+
+void Metrics::Init(Handle<Object> exports) {
+  exports->Set(Nan::New("getMetrics").ToLocalChecked(),
+      Nan::New<FunctionTemplate>(GetMetrics)->GetFunction());
+}
@@ -0,0 +1,61 @@
+#ifndef SRC_METRICS_H_
+#define SRC_METRICS_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+
+#include "nan.h"
+#include "v8.h"  // IWYU pragma: keep
+
+namespace node_webrtc {
+
+//
+// Relaxed atomic counters kept per PeerConnection and per DataChannel. Every
+// update is also applied to the owner's parent, if any (a channel's
+// PeerConnection), and to the process-wide totals, so reading any level is
+// a handful of loads and never involves the signaling thread.
+//
+class Metrics {
+ public:
+  enum Counter {
+    MESSAGES_SENT,
+    BYTES_SENT,
+    MESSAGES_RECEIVED,
+    BYTES_RECEIVED,
+    EVENTS_QUEUED,
+    EVENTS_DRAINED,
+    WAKEUPS,
+    DRAIN_TIME_NS,
+    COUNTER_COUNT
+  };
+
+  explicit Metrics(std::shared_ptr<Metrics> parent = nullptr);
+
+  void Add(Counter counter, uint64_t value = 1);
+  uint64_t Get(Counter counter) const;
+
+  v8::Local<v8::Object> ToObject() const;
+
+  static Metrics* Global();
+
+  //
+  // Nodejs wrapping.
+  //
+  static void Init(v8::Handle<v8::Object> exports);
+  static NAN_METHOD(GetMetrics);
+
+ private:
+  Metrics(const Metrics&);
+  Metrics& operator=(const Metrics&);
+
+  void AddLocal(Counter counter, uint64_t value);
+
+  std::shared_ptr<Metrics> _parent;
+  std::atomic<uint64_t> _counters[COUNTER_COUNT];
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_METRICS_H_
@@ -11,12 +11,15 @@
 #include "create-answer-observer.h"
 #include "create-offer-observer.h"
 #include "datachannel.h"
+#include "peerconnectionfactory.h"
+#include "rtcstatsreport.h"
 #include "rtcstatsresponse.h"
 #include "set-local-description-observer.h"
 #include "set-remote-description-observer.h"
 #include "stats-observer.h"
 
 using node_webrtc::PeerConnection;
+using v8::Array;
 using v8::External;
 using v8::Function;
 using v8::FunctionTemplate;
@@ -29,14 +32,16 @@ using v8::String;
 using v8::Uint32;
 using v8::Value;
 
-Nan::Persistent<Function> PeerConnection::constructor;
-
 //
 // PeerConnection
 //
 
 PeerConnection::PeerConnection()
-: loop(uv_default_loop()) {
+: _state(IsolateState::Current()),
+  _dispatcher(_state->dispatcher()),
+  _shutdown(false),
+  _stopRequested(false),
+  _metrics(std::make_shared<Metrics>()) {
   _createOfferObserver = new rtc::RefCountedObject<CreateOfferObserver>(this);
   _createAnswerObserver = new rtc::RefCountedObject<CreateAnswerObserver>(this);
   _setLocalDescriptionObserver = new rtc::RefCountedObject<SetLocalDescriptionObserver>(this);
@@ -53,135 +58,218 @@ PeerConnection::PeerConnection()
   constraints.AddMandatory(webrtc::MediaConstraintsInterface::kOfferToReceiveAudio, webrtc::MediaConstraintsInterface::kValueFalse);
   constraints.AddMandatory(webrtc::MediaConstraintsInterface::kOfferToReceiveVideo, webrtc::MediaConstraintsInterface::kValueFalse);
 
-  _jinglePeerConnectionFactory = webrtc::CreatePeerConnectionFactory();
-  _jinglePeerConnection = _jinglePeerConnectionFactory->CreatePeerConnection(_iceServers, &constraints, nullptr, nullptr, this);
-
-  uv_mutex_init(&lock);
-  uv_async_init(loop, &async, reinterpret_cast<uv_async_cb>(Run));
+  _factory = PeerConnectionFactory::Acquire();
+  _jinglePeerConnection = _factory->factory()->CreatePeerConnection(_iceServers, &constraints, nullptr, nullptr, this);
 
-  async.data = this;
+  _dispatcher->Ref();
+  _state->AddResource(this);
 }
 
 PeerConnection::~PeerConnection() {
   TRACE_CALL;
+  if (_state) {
+    _state->RemoveResource(this);
+  }
+  Teardown();
+  TRACE_END;
+}
+
+void PeerConnection::Teardown() {
+  TRACE_CALL;
+  _state = nullptr;
+
+  // Close and drop the libwebrtc connection first, so that no observer
+  // callback can queue an event once this object is off the dispatcher.
+  if (_jinglePeerConnection) {
+    _jinglePeerConnection->Close();
+    _jinglePeerConnection = nullptr;
+  }
+  _dispatcher->Cancel(this);
+  Stop();
+
+  // Free whatever was queued but never handled.
+  _batch.clear();
+  _events.Swap(&_batch);
+  for (std::vector<AsyncEvent>::size_type i = 0; i < _batch.size(); i++) {
+    delete _batch[i].data;
+  }
+  _metrics->Add(Metrics::EVENTS_DRAINED, _batch.size());
+  _batch.clear();
+
+  if (_factory) {
+    PeerConnectionFactory::Release(_factory);
+    _factory = nullptr;
+  }
   TRACE_END;
 }
 
-void PeerConnection::QueueEvent(AsyncEventType type, void* data) {
+void PeerConnection::QueueEvent(AsyncEventType type, EventPayload* data) {
   TRACE_CALL;
   AsyncEvent evt;
   evt.type = type;
   evt.data = data;
-  uv_mutex_lock(&lock);
-  _events.push(evt);
-  uv_mutex_unlock(&lock);
-
-  uv_async_send(&async);
+  _metrics->Add(Metrics::EVENTS_QUEUED);
+  if (_events.Push(evt)) {
+    _dispatcher->Schedule(this);
+  }
   TRACE_END;
 }
 
-void PeerConnection::Run(uv_async_t* handle, int status) {
+void PeerConnection::Emit(Callback callback, int argc, Local<Value> argv[]) {
+  // An internal field load, not a property lookup.
+  Local<Value> function = handle()->GetInternalField(kCallbacksField).As<Array>()->Get(callback);
+  if (function->IsFunction()) {
+    Nan::MakeCallback(handle(), function.As<Function>(), argc, argv);
+  }
+}
+
+void PeerConnection::Stop() {
+  if (!_shutdown) {
+    _shutdown = true;
+    _dispatcher->Unref();
+  }
+}
+
+const PeerConnection::EventHandler PeerConnection::kEventHandlers[] = {
+  &Dispatch<SdpEvent, &PeerConnection::HandleSdp>,  // CREATE_OFFER_SUCCESS
+  &Dispatch<ErrorEvent, &PeerConnection::HandleError>,  // CREATE_OFFER_ERROR
+  &Dispatch<SdpEvent, &PeerConnection::HandleSdp>,  // CREATE_ANSWER_SUCCESS
+  &Dispatch<ErrorEvent, &PeerConnection::HandleError>,  // CREATE_ANSWER_ERROR
+  &Dispatch<EventPayload, &PeerConnection::HandleSuccess>,  // SET_LOCAL_DESCRIPTION_SUCCESS
+  &Dispatch<ErrorEvent, &PeerConnection::HandleError>,  // SET_LOCAL_DESCRIPTION_ERROR
+  &Dispatch<EventPayload, &PeerConnection::HandleSuccess>,  // SET_REMOTE_DESCRIPTION_SUCCESS
+  &Dispatch<ErrorEvent, &PeerConnection::HandleError>,  // SET_REMOTE_DESCRIPTION_ERROR
+  &Dispatch<EventPayload, &PeerConnection::HandleSuccess>,  // ADD_ICE_CANDIDATE_SUCCESS
+  &Dispatch<ErrorEvent, &PeerConnection::HandleError>,  // ADD_ICE_CANDIDATE_ERROR
+  &Dispatch<DataChannelEvent, &PeerConnection::HandleDataChannel>,  // NOTIFY_DATA_CHANNEL
+  &Dispatch<EventPayload, &PeerConnection::HandleIgnored>,  // NOTIFY_CONNECTION
+  &Dispatch<EventPayload, &PeerConnection::HandleIgnored>,  // NOTIFY_CLOSED_CONNECTION
+  &Dispatch<IceEvent, &PeerConnection::HandleIceCandidate>,  // ICE_CANDIDATE
+  &Dispatch<StateEvent, &PeerConnection::HandleSignalingStateChange>,  // SIGNALING_STATE_CHANGE
+  &Dispatch<StateEvent, &PeerConnection::HandleIceConnectionStateChange>,  // ICE_CONNECTION_STATE_CHANGE
+  &Dispatch<StateEvent, &PeerConnection::HandleIceGatheringStateChange>,  // ICE_GATHERING_STATE_CHANGE
+  &Dispatch<EventPayload, &PeerConnection::HandleIgnored>,  // NOTIFY_ADD_STREAM
+  &Dispatch<EventPayload, &PeerConnection::HandleIgnored>,  // NOTIFY_REMOVE_STREAM
+  &Dispatch<GetStatsEvent, &PeerConnection::HandleGetStats>,  // GET_STATS_SUCCESS
+};
+
+void PeerConnection::Run() {
+  static_assert(sizeof(kEventHandlers) / sizeof(kEventHandlers[0]) == EVENT_TYPE_COUNT,
+                "every AsyncEventType needs a handler");
   Nan::HandleScope scope;
 
-  PeerConnection* self = static_cast<PeerConnection*>(handle->data);
+  PeerConnection* self = this;
   TRACE_CALL_P((uintptr_t)self);
-  Local<Object> pc = self->handle();
-  bool do_shutdown = false;
-
-  while (true) {
-    uv_mutex_lock(&self->lock);
-    bool empty = self->_events.empty();
-    if (empty) {
-      uv_mutex_unlock(&self->lock);
-      break;
-    }
-    AsyncEvent evt = self->_events.front();
-    self->_events.pop();
-    uv_mutex_unlock(&self->lock);
+  uint64_t start = uv_hrtime();
+
+  self->_events.Swap(&self->_batch);
+  for (std::vector<AsyncEvent>::size_type i = 0; i < self->_batch.size(); i++) {
+    AsyncEvent evt = self->_batch[i];
 
     TRACE_U("evt.type", evt.type);
-    if (PeerConnection::ERROR_EVENT & evt.type) {
-      PeerConnection::ErrorEvent* data = static_cast<PeerConnection::ErrorEvent*>(evt.data);
-      Local<Function> callback = Local<Function>::Cast(pc->Get(Nan::New("onerror").ToLocalChecked()));
-      Local<Value> argv[1];
-      argv[0] = Nan::Error(data->msg.c_str());
-      Nan::MakeCallback(pc, callback, 1, argv);
-    } else if (PeerConnection::SDP_EVENT & evt.type) {
-      PeerConnection::SdpEvent* data = static_cast<PeerConnection::SdpEvent*>(evt.data);
-      Local<Function> callback = Local<Function>::Cast(pc->Get(Nan::New("onsuccess").ToLocalChecked()));
-      Local<Value> argv[1];
-      argv[0] = Nan::New(data->desc.c_str()).ToLocalChecked();
-      Nan::MakeCallback(pc, callback, 1, argv);
-    } else if (PeerConnection::GET_STATS_SUCCESS & evt.type) {
-      PeerConnection::GetStatsEvent* data = static_cast<PeerConnection::GetStatsEvent*>(evt.data);
-      Nan::Callback *callback = data->callback;
-      Local<Value> cargv[1];
-      cargv[0] = Nan::New<External>(static_cast<void*>(&data->reports));
-      Local<Value> argv[1];
-      argv[0] = Nan::New(RTCStatsResponse::constructor)->NewInstance(1, cargv);
-      callback->Call(1, argv);
-    } else if (PeerConnection::VOID_EVENT & evt.type) {
-      Local<Function> callback = Local<Function>::Cast(pc->Get(Nan::New("onsuccess").ToLocalChecked()));
-      Local<Value> argv[0];
-      Nan::MakeCallback(pc, callback, 0, argv);
-    } else if (PeerConnection::SIGNALING_STATE_CHANGE & evt.type) {
-      PeerConnection::StateEvent* data = static_cast<PeerConnection::StateEvent*>(evt.data);
-      Local<Function> callback = Local<Function>::Cast(pc->Get(Nan::New("onsignalingstatechange").ToLocalChecked()));
-      if (!callback.IsEmpty()) {
-        Local<Value> argv[1];
-        argv[0] = Nan::New<Uint32>(data->state);
-        Nan::MakeCallback(pc, callback, 1, argv);
-      }
-      if (webrtc::PeerConnectionInterface::kClosed == data->state) {
-        do_shutdown = true;
-      }
-    } else if (PeerConnection::ICE_CONNECTION_STATE_CHANGE & evt.type) {
-      PeerConnection::StateEvent* data = static_cast<PeerConnection::StateEvent*>(evt.data);
-      Local<Function> callback = Local<Function>::Cast(pc->Get(Nan::New("oniceconnectionstatechange").ToLocalChecked()));
-      if (!callback.IsEmpty()) {
-        Local<Value> argv[1];
-        argv[0] = Nan::New<Uint32>(data->state);
-        Nan::MakeCallback(pc, callback, 1, argv);
-      }
-    } else if (PeerConnection::ICE_GATHERING_STATE_CHANGE & evt.type) {
-      PeerConnection::StateEvent* data = static_cast<PeerConnection::StateEvent*>(evt.data);
-      Local<Function> callback = Local<Function>::Cast(pc->Get(Nan::New("onicegatheringstatechange").ToLocalChecked()));
-      if (!callback.IsEmpty()) {
-        Local<Value> argv[1];
-        argv[0] = Nan::New<Uint32>(data->state);
-        Nan::MakeCallback(pc, callback, 1, argv);
-      }
-    } else if (PeerConnection::ICE_CANDIDATE & evt.type) {
-      PeerConnection::IceEvent* data = static_cast<PeerConnection::IceEvent*>(evt.data);
-      Local<Function> callback = Local<Function>::Cast(pc->Get(Nan::New("onicecandidate").ToLocalChecked()));
-      if (!callback.IsEmpty()) {
-        Local<Value> argv[3];
-        argv[0] = Nan::New(data->candidate.c_str()).ToLocalChecked();
-        argv[1] = Nan::New(data->sdpMid.c_str()).ToLocalChecked();
-        argv[2] = Nan::New<Integer>(data->sdpMLineIndex);
-        Nan::MakeCallback(pc, callback, 3, argv);
-      }
-    } else if (PeerConnection::NOTIFY_DATA_CHANNEL & evt.type) {
-      PeerConnection::DataChannelEvent* data = static_cast<PeerConnection::DataChannelEvent*>(evt.data);
-      DataChannelObserver* observer = data->observer;
-      Local<Value> cargv[1];
-      cargv[0] = Nan::New<External>(static_cast<void*>(observer));
-      Local<Value> dc = Nan::New(DataChannel::constructor)->NewInstance(1, cargv);
-
-      Local<Function> callback = Local<Function>::Cast(pc->Get(Nan::New("ondatachannel").ToLocalChecked()));
-      Local<Value> argv[1];
-      argv[0] = dc;
-      Nan::MakeCallback(pc, callback, 1, argv);
-    }
+    kEventHandlers[evt.type](self, evt.data);
+    delete evt.data;
   }
+  self->_metrics->Add(Metrics::EVENTS_DRAINED, self->_batch.size());
+  self->_batch.clear();
+
+  self->_metrics->Add(Metrics::WAKEUPS);
+  self->_metrics->Add(Metrics::DRAIN_TIME_NS, uv_hrtime() - start);
 
-  if (do_shutdown) {
-    uv_close(reinterpret_cast<uv_handle_t*>(&self->async), nullptr);
+  if (self->_stopRequested) {
+    self->Stop();
   }
 
   TRACE_END;
 }
 
+void PeerConnection::HandleError(ErrorEvent* data) {
+  Local<Value> argv[1];
+  argv[0] = Nan::Error(data->msg.c_str());
+  Emit(ON_ERROR, 1, argv);
+}
+
+void PeerConnection::HandleSdp(SdpEvent* data) {
+  Local<Value> argv[1];
+  argv[0] = Nan::New(data->desc.c_str()).ToLocalChecked();
+  Emit(ON_SUCCESS, 1, argv);
+}
+
+void PeerConnection::HandleSuccess(EventPayload* data) {
+  Emit(ON_SUCCESS, 0, nullptr);
+}
+
+void PeerConnection::HandleGetStats(GetStatsEvent* data) {
+  Local<Value> argv[1];
+  if (data->plain) {
+    Local<Object> reports = Nan::New<Object>();
+    for (std::vector<StatsReportCopy>::size_type i = 0; i < data->reports.size(); i++) {
+      const StatsReportCopy& report = data->reports[i];
+      reports->Set(Nan::New(report.id).ToLocalChecked(), RTCStatsReport::ToObject(report));
+    }
+    argv[0] = reports;
+  } else {
+    // RTCStatsResponse takes over the copies, leaving |data| empty.
+    Local<Value> cargv[1];
+    cargv[0] = Nan::New<External>(static_cast<void*>(&data->reports));
+    argv[0] = Nan::New(_state->statsResponseConstructor)->NewInstance(1, cargv);
+  }
+  data->callback->Call(1, argv);
+}
+
+void PeerConnection::HandleSignalingStateChange(StateEvent* data) {
+  Local<Value> argv[1];
+  argv[0] = Nan::New<Uint32>(data->state);
+  Emit(ON_SIGNALING_STATE_CHANGE, 1, argv);
+  if (webrtc::PeerConnectionInterface::kClosed == data->state) {
+    _stopRequested = true;
+  }
+}
+
+void PeerConnection::HandleIceConnectionStateChange(StateEvent* data) {
+  Local<Value> argv[1];
+  argv[0] = Nan::New<Uint32>(data->state);
+  Emit(ON_ICE_CONNECTION_STATE_CHANGE, 1, argv);
+}
+
+void PeerConnection::HandleIceGatheringStateChange(StateEvent* data) {
+  Local<Value> argv[1];
+  argv[0] = Nan::New<Uint32>(data->state);
+  Emit(ON_ICE_GATHERING_STATE_CHANGE, 1, argv);
+}
+
+void PeerConnection::HandleIceCandidate(IceEvent* data) {
+  Local<Value> argv[3];
+  argv[0] = Nan::New(data->candidate.c_str()).ToLocalChecked();
+  argv[1] = Nan::New(data->sdpMid.c_str()).ToLocalChecked();
+  argv[2] = Nan::New<Integer>(data->sdpMLineIndex);
+  Emit(ON_ICE_CANDIDATE, 3, argv);
+}
+
+void PeerConnection::HandleDataChannel(DataChannelEvent* data) {
+  // The DataChannel adopts and deletes the observer.
+  DataChannelObserver* observer = data->observer;
+  data->observer = nullptr;
+
+  Local<Value> cargv[1];
+  cargv[0] = Nan::New<External>(static_cast<void*>(observer));
+  Local<Value> dc = Nan::New(_state->dataChannelConstructor)->NewInstance(1, cargv);
+
+  Local<Value> argv[1];
+  argv[0] = dc;
+  Emit(ON_DATA_CHANNEL, 1, argv);
+}
+
+void PeerConnection::HandleIgnored(EventPayload* data) {
+}
+
+PeerConnection::DataChannelEvent::~DataChannelEvent() {
+  if (observer) {
+    observer->_jingleDataChannel->UnregisterObserver();
+    delete observer;
+  }
+}
+
 void PeerConnection::OnError() {
   TRACE_CALL;
   TRACE_END;
@@ -190,36 +278,36 @@ void PeerConnection::OnError() {
 void PeerConnection::OnSignalingChange(webrtc::PeerConnectionInterface::SignalingState new_state) {
   TRACE_CALL;
   StateEvent* data = new StateEvent(static_cast<uint32_t>(new_state));
-  QueueEvent(PeerConnection::SIGNALING_STATE_CHANGE, static_cast<void*>(data));
+  QueueEvent(PeerConnection::SIGNALING_STATE_CHANGE, data);
   TRACE_END;
 }
 
 void PeerConnection::OnIceConnectionChange(webrtc::PeerConnectionInterface::IceConnectionState new_state) {
   TRACE_CALL;
   StateEvent* data = new StateEvent(static_cast<uint32_t>(new_state));
-  QueueEvent(PeerConnection::ICE_CONNECTION_STATE_CHANGE, static_cast<void*>(data));
+  QueueEvent(PeerConnection::ICE_CONNECTION_STATE_CHANGE, data);
   TRACE_END;
 }
 
 void PeerConnection::OnIceGatheringChange(webrtc::PeerConnectionInterface::IceGatheringState new_state) {
   TRACE_CALL;
   StateEvent* data = new StateEvent(static_cast<uint32_t>(new_state));
-  QueueEvent(PeerConnection::ICE_GATHERING_STATE_CHANGE, static_cast<void*>(data));
+  QueueEvent(PeerConnection::ICE_GATHERING_STATE_CHANGE, data);
   TRACE_END;
 }
 
 void PeerConnection::OnIceCandidate(const webrtc::IceCandidateInterface* candidate) {
   TRACE_CALL;
   PeerConnection::IceEvent* data = new PeerConnection::IceEvent(candidate);
-  QueueEvent(PeerConnection::ICE_CANDIDATE, static_cast<void*>(data));
+  QueueEvent(PeerConnection::ICE_CANDIDATE, data);
   TRACE_END;
 }
 
 void PeerConnection::OnDataChannel(webrtc::DataChannelInterface* jingle_data_channel) {
   TRACE_CALL;
-  DataChannelObserver* observer = new DataChannelObserver(jingle_data_channel);
+  DataChannelObserver* observer = new DataChannelObserver(jingle_data_channel, _factory, _metrics);
   PeerConnection::DataChannelEvent* data = new PeerConnection::DataChannelEvent(observer);
-  QueueEvent(PeerConnection::NOTIFY_DATA_CHANNEL, static_cast<void*>(data));
+  QueueEvent(PeerConnection::NOTIFY_DATA_CHANNEL, data);
   TRACE_END;
 }
 
@@ -237,6 +325,7 @@ NAN_METHOD(PeerConnection::New) {
 
   PeerConnection* obj = new PeerConnection();
   obj->Wrap(info.This());
+  info.This()->SetInternalField(kCallbacksField, Nan::New<Array>(CALLBACK_COUNT));
 
   TRACE_END;
   info.GetReturnValue().Set(info.This());
@@ -316,10 +405,10 @@ NAN_METHOD(PeerConnection::AddIceCandidate) {
   webrtc::IceCandidateInterface* ci = webrtc::CreateIceCandidate(sdp_mid, sdp_mline_index, candidate, &sdpParseError);
 
   if (self->_jinglePeerConnection->AddIceCandidate(ci)) {
-    self->QueueEvent(PeerConnection::ADD_ICE_CANDIDATE_SUCCESS, static_cast<void*>(nullptr));
+    self->QueueEvent(PeerConnection::ADD_ICE_CANDIDATE_SUCCESS, nullptr);
   } else {
     PeerConnection::ErrorEvent* data = new PeerConnection::ErrorEvent(std::string("Failed to set ICE candidate."));
-    self->QueueEvent(PeerConnection::ADD_ICE_CANDIDATE_ERROR, static_cast<void*>(data));
+    self->QueueEvent(PeerConnection::ADD_ICE_CANDIDATE_ERROR, data);
   }
 
   TRACE_END;
@@ -372,33 +461,73 @@ NAN_METHOD(PeerConnection::CreateDataChannel) {
   }
 
   rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel_interface = self->_jinglePeerConnection->CreateDataChannel(*label, &dataChannelInit);
-  DataChannelObserver* observer = new DataChannelObserver(data_channel_interface);
+  DataChannelObserver* observer = new DataChannelObserver(data_channel_interface, self->_factory, self->_metrics);
 
   Local<Value> cargv[1];
   cargv[0] = Nan::New<External>(static_cast<void*>(observer));
-  Local<Value> dc = Nan::New(DataChannel::constructor)->NewInstance(1, cargv);
+  Local<Value> dc = Nan::New(self->_state->dataChannelConstructor)->NewInstance(1, cargv);
 
   TRACE_END;
   info.GetReturnValue().Set(dc);
 }
 
+static void ReadStrings(Local<Value> value, std::vector<std::string>* strings) {
+  if (!value->IsArray()) {
+    return;
+  }
+  Local<v8::Array> array = value.As<v8::Array>();
+  for (uint32_t i = 0; i < array->Length(); i++) {
+    strings->push_back(*String::Utf8Value(array->Get(i)->ToString()));
+  }
+}
+
 NAN_METHOD(PeerConnection::GetStats) {
   TRACE_CALL;
+  RequestStats(info, false);
+  TRACE_END;
+}
+
+NAN_METHOD(PeerConnection::GetStatsObject) {
+  TRACE_CALL;
+  RequestStats(info, true);
+  TRACE_END;
+}
+
+void PeerConnection::RequestStats(const Nan::FunctionCallbackInfo<Value>& info, bool plain) {
+  TRACE_CALL;
 
   PeerConnection* self = Nan::ObjectWrap::Unwrap<PeerConnection>(info.This());
 
+  // The optional third argument narrows the request:
+  // { types: [String], ids: [String], level: 'standard' | 'debug' }.
+  StatsSelector selector;
+  webrtc::PeerConnectionInterface::StatsOutputLevel level =
+      webrtc::PeerConnectionInterface::kStatsOutputLevelStandard;
+  if (info[2]->IsObject()) {
+    Local<Object> options = info[2].As<Object>();
+    ReadStrings(options->Get(Nan::New("types").ToLocalChecked()), &selector.types);
+    ReadStrings(options->Get(Nan::New("ids").ToLocalChecked()), &selector.ids);
+
+    Local<Value> value = options->Get(Nan::New("level").ToLocalChecked());
+    if (value->IsString() && std::string("debug") == *String::Utf8Value(value)) {
+      level = webrtc::PeerConnectionInterface::kStatsOutputLevelDebug;
+    }
+  }
+
+  // |onSuccess| is handed to the GetStatsEvent, which deletes it.
   Nan::Callback *onSuccess = new Nan::Callback(info[0].As<Function>());
-  Nan::Callback *onFailure = new Nan::Callback(info[1].As<Function>());
   rtc::scoped_refptr<StatsObserver> statsObserver =
-     new rtc::RefCountedObject<StatsObserver>(self, onSuccess);
+     new rtc::RefCountedObject<StatsObserver>(self, onSuccess, plain, selector);
+
+  if (!self->_jinglePeerConnection->GetStats(statsObserver, level)) {
+    delete onSuccess;
 
-  if (!self->_jinglePeerConnection->GetStats(statsObserver,
-    webrtc::PeerConnectionInterface::kStatsOutputLevelStandard)) {
     // TODO: Include error?
+    Nan::Callback onFailure(info[1].As<Function>());
     Local<Value> argv[] = {
       Nan::Null()
     };
-    onFailure->Call(1, argv);
+    onFailure.Call(1, argv);
   }
 
   TRACE_END;
@@ -411,6 +540,15 @@ NAN_METHOD(PeerConnection::UpdateIce) {
   info.GetReturnValue().Set(Nan::Undefined());
 }
 
+NAN_METHOD(PeerConnection::GetMetrics) {
+  TRACE_CALL;
+
+  PeerConnection* self = Nan::ObjectWrap::Unwrap<PeerConnection>(info.This());
+
+  TRACE_END;
+  info.GetReturnValue().Set(self->_metrics->ToObject());
+}
+
 NAN_METHOD(PeerConnection::Close) {
   TRACE_CALL;
 
@@ -500,6 +638,27 @@ NAN_GETTER(PeerConnection::GetIceGatheringState) {
   info.GetReturnValue().Set(Nan::New<Number>(static_cast<uint32_t>(state)));
 }
 
+NAN_GETTER(PeerConnection::GetCallback) {
+  Local<Array> callbacks = info.Holder()->GetInternalField(kCallbacksField).As<Array>();
+  Local<Value> callback = callbacks->Get(info.Data()->Uint32Value());
+
+  if (callback->IsFunction()) {
+    info.GetReturnValue().Set(callback);
+  } else {
+    info.GetReturnValue().Set(Nan::Null());
+  }
+}
+
+NAN_SETTER(PeerConnection::SetCallback) {
+  Local<Array> callbacks = info.Holder()->GetInternalField(kCallbacksField).As<Array>();
+
+  if (value->IsFunction()) {
+    callbacks->Set(info.Data()->Uint32Value(), value);
+  } else {
+    callbacks->Set(info.Data()->Uint32Value(), Nan::Undefined());
+  }
+}
+
 NAN_SETTER(PeerConnection::ReadOnly) {
   INFO("PeerConnection::ReadOnly");
 }
@@ -507,13 +666,15 @@ NAN_SETTER(PeerConnection::ReadOnly) {
 void PeerConnection::Init(Handle<Object> exports) {
   Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
   tpl->SetClassName(Nan::New("PeerConnection").ToLocalChecked());
-  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+  tpl->InstanceTemplate()->SetInternalFieldCount(kCallbacksField + 1);
 
   Nan::SetPrototypeMethod(tpl, "createOffer", CreateOffer);
   Nan::SetPrototypeMethod(tpl, "createAnswer", CreateAnswer);
   Nan::SetPrototypeMethod(tpl, "setLocalDescription", SetLocalDescription);
   Nan::SetPrototypeMethod(tpl, "setRemoteDescription", SetRemoteDescription);
   Nan::SetPrototypeMethod(tpl, "getStats", GetStats);
+  Nan::SetPrototypeMethod(tpl, "getStatsObject", GetStatsObject);
+  Nan::SetPrototypeMethod(tpl, "getMetrics", GetMetrics);
   Nan::SetPrototypeMethod(tpl, "updateIce", UpdateIce);
   Nan::SetPrototypeMethod(tpl, "addIceCandidate", AddIceCandidate);
   Nan::SetPrototypeMethod(tpl, "createDataChannel", CreateDataChannel);
@@ -525,6 +686,17 @@ void PeerConnection::Init(Handle<Object> exports) {
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("iceConnectionState").ToLocalChecked(), GetIceConnectionState, ReadOnly);
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("iceGatheringState").ToLocalChecked(), GetIceGatheringState, ReadOnly);
 
-  constructor.Reset(tpl->GetFunction());
+  // Event handlers are stored natively when assigned, so dispatching an event
+  // in Run() needs neither a property lookup nor a string allocation.
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onerror").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_ERROR));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onsuccess").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_SUCCESS));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onsignalingstatechange").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_SIGNALING_STATE_CHANGE));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("oniceconnectionstatechange").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_ICE_CONNECTION_STATE_CHANGE));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onicegatheringstatechange").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_ICE_GATHERING_STATE_CHANGE));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onicecandidate").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_ICE_CANDIDATE));
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("ondatachannel").ToLocalChecked(), GetCallback, SetCallback, Nan::New<Uint32>(ON_DATA_CHANNEL));
+
+  IsolateState::Current()->peerConnectionConstructor.Reset(tpl->GetFunction());
+  IsolateState::Current()->peerConnectionTemplate.Reset(tpl);
   exports->Set(Nan::New("PeerConnection").ToLocalChecked(), tpl->GetFunction());
 }
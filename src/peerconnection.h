@@ -3,8 +3,9 @@
 
 #include <stdint.h>
 
+#include <memory>
 #include <string>
-#include <queue>
+#include <vector>
 
 #include "nan.h"
 #include "uv.h"
@@ -16,42 +17,56 @@
 #include "talk/app/webrtc/statstypes.h"
 #include "webrtc/base/scoped_ref_ptr.h"
 
+#include "async-dispatcher.h"
+#include "isolate-state.h"
+#include "event-payload.h"
+#include "event-queue.h"
+#include "metrics.h"
+#include "rtcstatsreport.h"
+
 namespace node_webrtc {
 
 class CreateOfferObserver;
 class CreateAnswerObserver;
 class DataChannelObserver;
+class PeerConnectionFactory;
 class SetLocalDescriptionObserver;
 class SetRemoteDescriptionObserver;
 
 class PeerConnection
 : public Nan::ObjectWrap
+, public AsyncDispatcher::Target
+, public IsolateState::Resource
 , public webrtc::PeerConnectionObserver {
  public:
-  struct ErrorEvent {
+  struct ErrorEvent : public EventPayload {
     explicit ErrorEvent(const std::string& msg)
-    : msg(msg) {}
+    : msg(msg) {
+      Account(msg.size());
+    }
 
     std::string msg;
   };
 
-  struct SdpEvent {
+  struct SdpEvent : public EventPayload {
     explicit SdpEvent(webrtc::SessionDescriptionInterface* sdp) {
       if (!sdp->ToString(&desc)) {
         desc = "";
       }
       type = sdp->type();
+      Account(desc.size() + type.size());
     }
 
     std::string type;
     std::string desc;
   };
 
-  struct IceEvent {
+  struct IceEvent : public EventPayload {
     explicit IceEvent(const webrtc::IceCandidateInterface* ice_candidate)
     : sdpMLineIndex(ice_candidate->sdp_mline_index())
     , sdpMid(ice_candidate->sdp_mid()) {
       ice_candidate->ToString(&candidate);
+      Account(sdpMid.size() + candidate.size());
     }
 
     uint32_t sdpMLineIndex;
@@ -59,58 +74,83 @@ class PeerConnection
     std::string candidate;
   };
 
-  struct StateEvent {
+  struct StateEvent : public EventPayload {
     explicit StateEvent(uint32_t state)
     : state(state) {}
 
     uint32_t state;
   };
 
-  struct DataChannelEvent {
+  // Owns |observer| until a DataChannel adopts it.
+  struct DataChannelEvent : public EventPayload {
     explicit DataChannelEvent(DataChannelObserver* observer)
     : observer(observer) {}
+    ~DataChannelEvent();
 
     DataChannelObserver* observer;
   };
 
-  struct GetStatsEvent {
-    GetStatsEvent(Nan::Callback* callback, webrtc::StatsReports reports)
-    : callback(callback), reports(reports) {}
+  // Takes the contents of |reports|, which StatsObserver copied on the
+  // signaling thread; the Node thread never sees a libwebrtc report.
+  struct GetStatsEvent : public EventPayload {
+    GetStatsEvent(Nan::Callback* callback, std::vector<StatsReportCopy>* reports, bool plain)
+    : callback(callback), plain(plain) {
+      this->reports.swap(*reports);
+      size_t size = this->reports.size() * sizeof(StatsReportCopy);
+      for (std::vector<StatsReportCopy>::size_type i = 0; i < this->reports.size(); i++) {
+        const StatsReportCopy& report = this->reports[i];
+        size += report.id.size() + report.type.size();
+        for (std::vector<int>::size_type j = 0; j < report.values.size(); j++) {
+          size += report.values[j].first.size() + report.values[j].second.size();
+        }
+      }
+      Account(size);
+    }
+    ~GetStatsEvent() {
+      delete callback;
+    }
 
     Nan::Callback* callback;
-    webrtc::StatsReports reports;
+    std::vector<StatsReportCopy> reports;
+
+    // Deliver a plain object keyed by report id instead of an RTCStatsResponse.
+    bool plain;
   };
 
+  // Indexes into the handler table in peerconnection.cc.
   enum AsyncEventType {
-    CREATE_OFFER_SUCCESS = 0x1 << 0,  // 1
-    CREATE_OFFER_ERROR = 0x1 << 1,  // 2
-    CREATE_ANSWER_SUCCESS = 0x1 << 2,  // 4
-    CREATE_ANSWER_ERROR = 0x1 << 3,  // 8
-    SET_LOCAL_DESCRIPTION_SUCCESS = 0x1 << 4,  // 16
-    SET_LOCAL_DESCRIPTION_ERROR = 0x1 << 5,  // 32
-    SET_REMOTE_DESCRIPTION_SUCCESS = 0x1 << 6,  // 64
-    SET_REMOTE_DESCRIPTION_ERROR = 0x1 << 7,  // 128
-    ADD_ICE_CANDIDATE_SUCCESS = 0x1 << 8,  // 256
-    ADD_ICE_CANDIDATE_ERROR = 0x1 << 9,  // 512
-    NOTIFY_DATA_CHANNEL = 0x1 << 10,  // 1024
-    NOTIFY_CONNECTION = 0x1 << 11,  // 2048
-    NOTIFY_CLOSED_CONNECTION = 0x1 << 12,  // 4096
-    ICE_CANDIDATE = 0x1 << 13,  // 8192
-    SIGNALING_STATE_CHANGE = 0x1 << 14,  // 16384
-    ICE_CONNECTION_STATE_CHANGE = 0x1 << 15,  // 32768
-    ICE_GATHERING_STATE_CHANGE = 0x1 << 16,  // 65536
-    NOTIFY_ADD_STREAM = 0x1 << 17,  // 131072
-    NOTIFY_REMOVE_STREAM = 0x1 << 18,  // 262144
-    GET_STATS_SUCCESS = 0x1 << 19,  // 524288
-
-    ERROR_EVENT = CREATE_OFFER_ERROR | CREATE_ANSWER_ERROR |
-                  SET_LOCAL_DESCRIPTION_ERROR | SET_REMOTE_DESCRIPTION_ERROR |
-                  ADD_ICE_CANDIDATE_ERROR,
-    SDP_EVENT = CREATE_OFFER_SUCCESS | CREATE_ANSWER_SUCCESS,
-    VOID_EVENT = SET_LOCAL_DESCRIPTION_SUCCESS | SET_REMOTE_DESCRIPTION_SUCCESS |
-                 ADD_ICE_CANDIDATE_SUCCESS | GET_STATS_SUCCESS,
-    STATE_EVENT = SIGNALING_STATE_CHANGE | ICE_CONNECTION_STATE_CHANGE |
-                  ICE_GATHERING_STATE_CHANGE
+    CREATE_OFFER_SUCCESS,
+    CREATE_OFFER_ERROR,
+    CREATE_ANSWER_SUCCESS,
+    CREATE_ANSWER_ERROR,
+    SET_LOCAL_DESCRIPTION_SUCCESS,
+    SET_LOCAL_DESCRIPTION_ERROR,
+    SET_REMOTE_DESCRIPTION_SUCCESS,
+    SET_REMOTE_DESCRIPTION_ERROR,
+    ADD_ICE_CANDIDATE_SUCCESS,
+    ADD_ICE_CANDIDATE_ERROR,
+    NOTIFY_DATA_CHANNEL,
+    NOTIFY_CONNECTION,
+    NOTIFY_CLOSED_CONNECTION,
+    ICE_CANDIDATE,
+    SIGNALING_STATE_CHANGE,
+    ICE_CONNECTION_STATE_CHANGE,
+    ICE_GATHERING_STATE_CHANGE,
+    NOTIFY_ADD_STREAM,
+    NOTIFY_REMOVE_STREAM,
+    GET_STATS_SUCCESS,
+    EVENT_TYPE_COUNT
+  };
+
+  enum Callback {
+    ON_ERROR,
+    ON_SUCCESS,
+    ON_SIGNALING_STATE_CHANGE,
+    ON_ICE_CONNECTION_STATE_CHANGE,
+    ON_ICE_GATHERING_STATE_CHANGE,
+    ON_ICE_CANDIDATE,
+    ON_DATA_CHANNEL,
+    CALLBACK_COUNT
   };
 
   PeerConnection();
@@ -134,7 +174,6 @@ class PeerConnection
   // Nodejs wrapping.
   //
   static void Init(v8::Handle<v8::Object> exports);
-  static Nan::Persistent<v8::Function> constructor;
   static NAN_METHOD(New);
 
   static NAN_METHOD(CreateOffer);
@@ -152,6 +191,8 @@ class PeerConnection
   static NAN_METHOD(RemoveStream);
   */
   static NAN_METHOD(GetStats);
+  static NAN_METHOD(GetStatsObject);
+  static NAN_METHOD(GetMetrics);
   static NAN_METHOD(Close);
 
   static NAN_GETTER(GetLocalDescription);
@@ -159,30 +200,79 @@ class PeerConnection
   static NAN_GETTER(GetIceConnectionState);
   static NAN_GETTER(GetSignalingState);
   static NAN_GETTER(GetIceGatheringState);
+  static NAN_GETTER(GetCallback);
+  static NAN_SETTER(SetCallback);
   static NAN_SETTER(ReadOnly);
 
-  void QueueEvent(AsyncEventType type, void* data);
+  // Takes ownership of |data|, which may be null.
+  void QueueEvent(AsyncEventType type, EventPayload* data);
+
+  webrtc::PeerConnectionInterface* jinglePeerConnection() { return _jinglePeerConnection.get(); }
+  // Null once the connection has been torn down.
+  PeerConnectionFactory* factory() { return _factory; }
 
  private:
-  static void Run(uv_async_t* handle, int status);
+  virtual void Run();
+
+  // Closes the libwebrtc connection, frees queued events and ends the
+  // factory lease. Called by the destructor, or by IsolateState when the
+  // worker exits first.
+  virtual void Teardown();
+
+  // The on* handlers live in a JS array in this internal field of the
+  // wrapper. Persistent handles would make them GC roots, and since they
+  // close over the wrapper it could never be collected.
+  static const int kCallbacksField = 1;
+
+  void Emit(Callback callback, int argc, v8::Local<v8::Value> argv[]);
+  void Stop();
+
+  static void RequestStats(const Nan::FunctionCallbackInfo<v8::Value>& info, bool plain);
 
   struct AsyncEvent {
     AsyncEventType type;
-    void* data;
+    EventPayload* data;
   };
 
-  uv_mutex_t lock;
-  uv_async_t async;
-  uv_loop_t *loop;
-  std::queue<AsyncEvent> _events;
+  // One entry per AsyncEventType. Each handler is a typed trampoline that
+  // casts the payload back to the type its event was queued with.
+  typedef void (*EventHandler)(PeerConnection* self, EventPayload* data);
+  static const EventHandler kEventHandlers[];
+
+  template <typename T, void (PeerConnection::*Handler)(T*)>
+  static void Dispatch(PeerConnection* self, EventPayload* data) {
+    (self->*Handler)(static_cast<T*>(data));
+  }
+
+  void HandleError(ErrorEvent* data);
+  void HandleSdp(SdpEvent* data);
+  void HandleSuccess(EventPayload* data);
+  void HandleGetStats(GetStatsEvent* data);
+  void HandleSignalingStateChange(StateEvent* data);
+  void HandleIceConnectionStateChange(StateEvent* data);
+  void HandleIceGatheringStateChange(StateEvent* data);
+  void HandleIceCandidate(IceEvent* data);
+  void HandleDataChannel(DataChannelEvent* data);
+  void HandleIgnored(EventPayload* data);
+
+  IsolateState* _state;
+  AsyncDispatcher* _dispatcher;
+  bool _shutdown;
+  bool _stopRequested;
+  EventQueue<AsyncEvent> _events;
+  std::vector<AsyncEvent> _batch;
   webrtc::PeerConnectionInterface::IceServers _iceServers;
 
+  // Shared with this connection's DataChannels, which roll their counters
+  // up into it.
+  std::shared_ptr<Metrics> _metrics;
+
   rtc::scoped_refptr<CreateOfferObserver> _createOfferObserver;
   rtc::scoped_refptr<CreateAnswerObserver> _createAnswerObserver;
   rtc::scoped_refptr<SetLocalDescriptionObserver> _setLocalDescriptionObserver;
   rtc::scoped_refptr<SetRemoteDescriptionObserver> _setRemoteDescriptionObserver;
 
-  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> _jinglePeerConnectionFactory;
+  PeerConnectionFactory* _factory;
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> _jinglePeerConnection;
 };
 
@@ -0,0 +1,194 @@
+#include "peerconnectionfactory.h"
+
+#include "common.h"
+
+using node_webrtc::PeerConnectionFactory;
+using node_webrtc::Trace;
+using v8::FunctionTemplate;
+using v8::Handle;
+using v8::Object;
+using v8::Uint32;
+
+uv_once_t PeerConnectionFactory::_once = UV_ONCE_INIT;
+uv_mutex_t PeerConnectionFactory::_lock;
+std::vector<PeerConnectionFactory*> PeerConnectionFactory::_pool;
+uint32_t PeerConnectionFactory::_poolSize = 1;
+
+//
+// PeerConnectionFactory
+//
+
+PeerConnectionFactory::PeerConnectionFactory()
+: _connections(0),
+  _refs(0) {
+  TRACE_CALL;
+
+  _signalingThread = new rtc::Thread();
+  _signalingThread->SetName("signaling_thread", nullptr);
+  _signalingThread->Start();
+
+  _workerThread = new rtc::Thread();
+  _workerThread->SetName("worker_thread", nullptr);
+  _workerThread->Start();
+
+  // rtc::Thread::SetName only names the thread for libwebrtc; name it for
+  // the trace export as well.
+  _signalingThread->Invoke<void>([]() {
+    Trace::SetThreadName("signaling_thread");
+  });
+  _workerThread->Invoke<void>([]() {
+    Trace::SetThreadName("worker_thread");
+  });
+
+  _jinglePeerConnectionFactory = webrtc::CreatePeerConnectionFactory(
+      _workerThread, _signalingThread, nullptr, nullptr, nullptr);
+
+  TRACE_END;
+}
+
+PeerConnectionFactory::~PeerConnectionFactory() {
+  TRACE_CALL;
+
+  _jinglePeerConnectionFactory = nullptr;
+
+  _workerThread->Stop();
+  delete _workerThread;
+  _signalingThread->Stop();
+  delete _signalingThread;
+
+  TRACE_END;
+}
+
+void PeerConnectionFactory::InitPool() {
+  uv_mutex_init(&_lock);
+
+  // Default to one factory per core; factories are only created on demand, so
+  // a process with a handful of connections still only starts a few threads.
+  uv_cpu_info_t* cpus;
+  int count;
+  if (0 == uv_cpu_info(&cpus, &count)) {
+    uv_free_cpu_info(cpus, count);
+    if (count > 0) {
+      _poolSize = static_cast<uint32_t>(count);
+    }
+  }
+}
+
+PeerConnectionFactory* PeerConnectionFactory::Acquire() {
+  TRACE_CALL;
+  uv_once(&_once, InitPool);
+  uv_mutex_lock(&_lock);
+
+  // Pick the least loaded factory. Factories beyond the current pool size
+  // (left over from a shrinking setFactoryPoolSize call) keep serving the
+  // connections they already have but take no new ones.
+  PeerConnectionFactory* selected = nullptr;
+  for (std::vector<PeerConnectionFactory*>::size_type i = 0; i < _pool.size() && i < _poolSize; i++) {
+    if (!selected || _pool[i]->_connections < selected->_connections) {
+      selected = _pool[i];
+    }
+  }
+
+  if ((!selected || selected->_connections > 0) && _pool.size() < _poolSize) {
+    selected = new PeerConnectionFactory();
+    _pool.push_back(selected);
+  }
+
+  selected->_connections++;
+  selected->_refs++;
+
+  uv_mutex_unlock(&_lock);
+  TRACE_END;
+  return selected;
+}
+
+void PeerConnectionFactory::Release(PeerConnectionFactory* factory) {
+  TRACE_CALL;
+  std::vector<PeerConnectionFactory*> idle;
+  uv_mutex_lock(&_lock);
+  factory->_connections--;
+  if (0 == --factory->_refs) {
+    TakeIdleSurplus(&idle);
+  }
+  uv_mutex_unlock(&_lock);
+  DeleteAll(idle);
+  TRACE_END;
+}
+
+void PeerConnectionFactory::Ref(PeerConnectionFactory* factory) {
+  uv_mutex_lock(&_lock);
+  factory->_refs++;
+  uv_mutex_unlock(&_lock);
+}
+
+void PeerConnectionFactory::Unref(PeerConnectionFactory* factory) {
+  TRACE_CALL;
+  std::vector<PeerConnectionFactory*> idle;
+  uv_mutex_lock(&_lock);
+  if (0 == --factory->_refs) {
+    TakeIdleSurplus(&idle);
+  }
+  uv_mutex_unlock(&_lock);
+  DeleteAll(idle);
+  TRACE_END;
+}
+
+void PeerConnectionFactory::TakeIdleSurplus(std::vector<PeerConnectionFactory*>* idle) {
+  // Factories below the pool size stay for reuse even when idle; only the
+  // surplus beyond it is removed, so their indices never shift.
+  std::vector<PeerConnectionFactory*>::size_type i = _poolSize;
+  while (i < _pool.size()) {
+    if (_pool[i]->_refs) {
+      i++;
+    } else {
+      idle->push_back(_pool[i]);
+      _pool.erase(_pool.begin() + i);
+    }
+  }
+}
+
+void PeerConnectionFactory::DeleteAll(const std::vector<PeerConnectionFactory*>& factories) {
+  // Stopping a factory's threads joins them, so this runs without _lock.
+  for (std::vector<PeerConnectionFactory*>::size_type i = 0; i < factories.size(); i++) {
+    delete factories[i];
+  }
+}
+
+NAN_METHOD(PeerConnectionFactory::SetPoolSize) {
+  TRACE_CALL;
+
+  REQ_INT_ARG(0, size);
+  if (size < 1) {
+    return Nan::ThrowRangeError("Factory pool size must be at least 1");
+  }
+
+  std::vector<PeerConnectionFactory*> idle;
+  uv_once(&_once, InitPool);
+  uv_mutex_lock(&_lock);
+  _poolSize = static_cast<uint32_t>(size);
+  TakeIdleSurplus(&idle);
+  uv_mutex_unlock(&_lock);
+  DeleteAll(idle);
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::Undefined());
+}
+
+NAN_METHOD(PeerConnectionFactory::GetPoolSize) {
+  TRACE_CALL;
+
+  uv_once(&_once, InitPool);
+  uv_mutex_lock(&_lock);
+  uint32_t size = _poolSize;
+  uv_mutex_unlock(&_lock);
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::New<Uint32>(size));
+}
+
+void PeerConnectionFactory::Init(Handle<Object> exports) {
+  exports->Set(Nan::New("setFactoryPoolSize").ToLocalChecked(),
+      Nan::New<FunctionTemplate>(SetPoolSize)->GetFunction());
+  exports->Set(Nan::New("getFactoryPoolSize").ToLocalChecked(),
+      Nan::New<FunctionTemplate>(GetPoolSize)->GetFunction());
+}
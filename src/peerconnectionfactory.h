@@ -0,0 +1,80 @@
+#ifndef SRC_PEERCONNECTIONFACTORY_H_
+#define SRC_PEERCONNECTIONFACTORY_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "nan.h"
+#include "uv.h"
+#include "v8.h"  // IWYU pragma: keep
+
+#include "talk/app/webrtc/peerconnectioninterface.h"
+#include "webrtc/base/scoped_ref_ptr.h"
+#include "webrtc/base/thread.h"
+
+namespace node_webrtc {
+
+//
+// A libwebrtc PeerConnectionFactory together with the signaling and worker
+// threads it runs on. Factories live in a process-wide pool; PeerConnections
+// lease one at construction so that the number of libwebrtc threads is bounded
+// by the pool size rather than by the number of connections.
+//
+class PeerConnectionFactory {
+ public:
+  PeerConnectionFactory();
+  ~PeerConnectionFactory();
+
+  webrtc::PeerConnectionFactoryInterface* factory() { return _jinglePeerConnectionFactory.get(); }
+  rtc::Thread* signalingThread() { return _signalingThread; }
+  rtc::Thread* workerThread() { return _workerThread; }
+
+  //
+  // Pool.
+  //
+  // Acquire() leases the least loaded factory to a PeerConnection; Release()
+  // ends the lease. Ref() and Unref() only keep a factory and its threads
+  // alive, for objects such as DataChannels that may outlive their
+  // PeerConnection but should not count towards its load. A factory left
+  // beyond the pool size by setFactoryPoolSize() is freed as soon as nothing
+  // references it.
+  //
+  static PeerConnectionFactory* Acquire();
+  static void Release(PeerConnectionFactory* factory);
+  static void Ref(PeerConnectionFactory* factory);
+  static void Unref(PeerConnectionFactory* factory);
+
+  //
+  // Nodejs wrapping.
+  //
+  static void Init(v8::Handle<v8::Object> exports);
+  static NAN_METHOD(SetPoolSize);
+  static NAN_METHOD(GetPoolSize);
+
+ private:
+  static void InitPool();
+
+  // Removes idle factories beyond the pool size from _pool and hands them to
+  // the caller to delete outside _lock. Called with _lock held.
+  static void TakeIdleSurplus(std::vector<PeerConnectionFactory*>* idle);
+  static void DeleteAll(const std::vector<PeerConnectionFactory*>& factories);
+
+  rtc::Thread* _signalingThread;
+  rtc::Thread* _workerThread;
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> _jinglePeerConnectionFactory;
+
+  // Number of PeerConnections currently leasing this factory, and of all
+  // references including those leases. Both guarded by _lock.
+  uint32_t _connections;
+  uint32_t _refs;
+
+  static uv_once_t _once;
+  static uv_mutex_t _lock;
+  static std::vector<PeerConnectionFactory*> _pool;
+  static uint32_t _poolSize;
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_PEERCONNECTIONFACTORY_H_
@@ -0,0 +1,85 @@
+#include "receive-ring.h"
+
+#include <string.h>
+
+using node_webrtc::ReceiveRing;
+
+static const size_t kMinCapacity = 64;
+
+static uint32_t Align(size_t size) {
+  return static_cast<uint32_t>((size + 7) & ~static_cast<size_t>(7));
+}
+
+static int32_t Load(int32_t* field) {
+  return __atomic_load_n(field, __ATOMIC_SEQ_CST);
+}
+
+static void Store(int32_t* field, int32_t value) {
+  __atomic_store_n(field, value, __ATOMIC_SEQ_CST);
+}
+
+bool ReceiveRing::IsValidLength(size_t length) {
+  return length >= kHeaderSize + kMinCapacity && length - kHeaderSize <= 0x7ffffff8;
+}
+
+ReceiveRing::ReceiveRing(uint8_t* memory, size_t length)
+: _header(reinterpret_cast<int32_t*>(memory)),
+  _data(memory + kHeaderSize),
+  _capacity(static_cast<uint32_t>((length - kHeaderSize) & ~static_cast<size_t>(7))) {
+  Store(&_header[HEAD], 0);
+  Store(&_header[TAIL], 0);
+  Store(&_header[DROPPED], 0);
+  Store(&_header[WAITING], 0);
+}
+
+ReceiveRing::Result ReceiveRing::Write(bool binary, const char* data, size_t size) {
+  uint32_t head = static_cast<uint32_t>(Load(&_header[HEAD]));
+  uint32_t tail = static_cast<uint32_t>(Load(&_header[TAIL]));
+  uint32_t need = size <= _capacity ? Align(kRecordHeaderSize + size) : _capacity + 1;
+
+  // Find a contiguous slot that keeps head from reaching tail again.
+  uint32_t offset;
+  bool wrap = false;
+  if (head >= tail) {
+    uint32_t room = _capacity - head;
+    if (need < room || (need == room && tail != 0)) {
+      offset = head;
+    } else if (need < tail) {
+      offset = 0;
+      wrap = true;
+    } else {
+      offset = _capacity;
+    }
+  } else {
+    offset = need < tail - head ? head : _capacity;
+  }
+
+  if (offset == _capacity) {
+    __atomic_add_fetch(&_header[DROPPED], 1, __ATOMIC_SEQ_CST);
+    return FULL;
+  }
+
+  if (wrap) {
+    uint32_t marker = kWrap;
+    memcpy(_data + head, &marker, sizeof(marker));
+  }
+
+  uint32_t length = static_cast<uint32_t>(size);
+  uint32_t flags = binary ? kBinary : 0;
+  memcpy(_data + offset, &length, sizeof(length));
+  memcpy(_data + offset + sizeof(length), &flags, sizeof(flags));
+  memcpy(_data + offset + kRecordHeaderSize, data, size);
+
+  uint32_t next = offset + need;
+  if (next == _capacity) {
+    next = 0;
+  }
+
+  // Publishing head releases the record. Reading |waiting| afterwards pairs
+  // with the consumer setting it before re-checking head, so a consumer that
+  // goes to sleep is always woken by one side or the other.
+  Store(&_header[HEAD], static_cast<int32_t>(next));
+  bool waiting = 0 != __atomic_exchange_n(&_header[WAITING], 0, __ATOMIC_SEQ_CST);
+
+  return (head == tail || waiting) ? WRITTEN_SIGNAL : WRITTEN;
+}
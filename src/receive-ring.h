@@ -0,0 +1,67 @@
+#ifndef SRC_RECEIVE_RING_H_
+#define SRC_RECEIVE_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace node_webrtc {
+
+//
+// Single-producer, single-consumer byte ring laid over caller-supplied shared
+// memory (a SharedArrayBuffer). The producer is the libwebrtc signaling
+// thread; the consumer is JavaScript, typically in a worker, using Atomics.
+//
+// Layout, all fields little-endian int32 so that JS can use an Int32Array:
+//
+//   [0] head     byte offset of the next record to write (producer)
+//   [1] tail     byte offset of the next record to read (consumer)
+//   [2] dropped  messages dropped because the ring was full
+//   [3] waiting  set to 1 by a consumer about to Atomics.wait() on head
+//
+// Records start at byte kHeaderSize and are 8-byte aligned:
+//
+//   uint32 length, uint32 flags (kBinary), payload, padding
+//
+// A length of kWrap means the rest of the data area is unused and reading
+// continues at offset 0. head == tail means the ring is empty; the producer
+// never lets head catch up with tail from behind.
+//
+class ReceiveRing {
+ public:
+  static const size_t kHeaderSize = 16;
+  static const size_t kRecordHeaderSize = 8;
+  static const uint32_t kWrap = 0xffffffff;
+  static const uint32_t kBinary = 0x1;
+
+  enum Index {
+    HEAD = 0,
+    TAIL = 1,
+    DROPPED = 2,
+    WAITING = 3
+  };
+
+  enum Result {
+    WRITTEN,         // the consumer already had data or is not waiting
+    WRITTEN_SIGNAL,  // the ring was empty or the consumer is waiting
+    FULL             // the message was dropped
+  };
+
+  // Returns false if |length| cannot hold a usable ring.
+  static bool IsValidLength(size_t length);
+
+  // |memory| must stay valid for the lifetime of the ring. The header is
+  // reset, so any records left by a previous user are discarded.
+  ReceiveRing(uint8_t* memory, size_t length);
+
+  // Producer side; never blocks.
+  Result Write(bool binary, const char* data, size_t size);
+
+ private:
+  int32_t* _header;
+  uint8_t* _data;
+  uint32_t _capacity;
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_RECEIVE_RING_H_
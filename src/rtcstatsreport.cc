@@ -1,11 +1,16 @@
 #include "rtcstatsreport.h"
 
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+
 #include <string>
-#include <vector>
 
 #include "common.h"
+#include "isolate-state.h"
 
 using node_webrtc::RTCStatsReport;
+using node_webrtc::StatsReportCopy;
 using v8::Array;
 using v8::External;
 using v8::Function;
@@ -17,15 +22,20 @@ using v8::Object;
 using v8::String;
 using v8::Value;
 
-Nan::Persistent<Function> RTCStatsReport::constructor;
-
-RTCStatsReport::RTCStatsReport(webrtc::StatsReport* report)
-: report(report) {}
 
-RTCStatsReport::~RTCStatsReport() {
-  report = nullptr;
+StatsReportCopy::StatsReportCopy(const webrtc::StatsReport* report)
+: id(report->id), type(report->type), timestamp(report->timestamp) {
+  values.reserve(report->values.size());
+  for (webrtc::StatsReport::Values::size_type i = 0; i != report->values.size(); i++) {
+    values.push_back(std::make_pair(report->values[i].display_name(), report->values[i].value));
+  }
 }
 
+RTCStatsReport::RTCStatsReport(const StatsReportCopy& report)
+: report(report), indexed(false) {}
+
+RTCStatsReport::~RTCStatsReport() {}
+
 NAN_METHOD(RTCStatsReport::New) {
   TRACE_CALL;
 
@@ -34,9 +44,9 @@ NAN_METHOD(RTCStatsReport::New) {
   }
 
   Local<External> _report = Local<External>::Cast(info[0]);
-  webrtc::StatsReport* report = static_cast<webrtc::StatsReport*>(_report->Value());
+  const StatsReportCopy* report = static_cast<const StatsReportCopy*>(_report->Value());
 
-  RTCStatsReport* obj = new RTCStatsReport(report);
+  RTCStatsReport* obj = new RTCStatsReport(*report);
   obj->Wrap(info.This());
 
   TRACE_END;
@@ -48,12 +58,10 @@ NAN_METHOD(RTCStatsReport::names) {
 
   RTCStatsReport* self = Nan::ObjectWrap::Unwrap<RTCStatsReport>(info.This());
 
-  std::vector<webrtc::StatsReport::Value> values = self->report->values;
+  const std::vector<std::pair<std::string, std::string> >& values = self->report.values;
   Local<Array> names = Nan::New<Array>(values.size());
   for (std::vector<int>::size_type i = 0; i != values.size(); i++) {
-    webrtc::StatsReport::Value value = values[i];
-    std::string display_name = value.display_name();
-    names->Set(i, Nan::New<String>(display_name).ToLocalChecked());
+    names->Set(i, Nan::New<String>(values[i].first).ToLocalChecked());
   }
 
   TRACE_END;
@@ -68,38 +76,86 @@ NAN_METHOD(RTCStatsReport::stat) {
   String::Utf8Value _name(info[0]->ToString());
   std::string name = std::string(*_name);
 
+  if (!self->indexed) {
+    self->BuildIndex();
+  }
+
   Local<Value> found = Nan::Undefined();
-  std::vector<webrtc::StatsReport::Value> values = self->report->values;
-  for (std::vector<int>::size_type i = 0; i != values.size(); i++) {
-    webrtc::StatsReport::Value value = values[i];
-    std::string display_name = std::string(value.display_name());
-    if (display_name.compare(name) == 0) {
-      found = Nan::New<String>(value.value).ToLocalChecked();
-    }
+  std::unordered_map<std::string, size_t>::const_iterator it = self->index.find(name);
+  if (it != self->index.end()) {
+    found = ToValue(self->report.values[it->second].second);
   }
 
   TRACE_END;
   info.GetReturnValue().Set(found);
 }
 
+void RTCStatsReport::BuildIndex() {
+  const std::vector<std::pair<std::string, std::string> >& values = report.values;
+  index.reserve(values.size());
+  for (std::vector<int>::size_type i = 0; i != values.size(); i++) {
+    // Later values win, as they did with the linear scan.
+    index[values[i].first] = i;
+  }
+  indexed = true;
+}
+
 NAN_GETTER(RTCStatsReport::GetTimestamp) {
   TRACE_CALL;
 
   RTCStatsReport *self = Nan::ObjectWrap::Unwrap<RTCStatsReport>(info.Holder());
-  double timestamp = self->report->timestamp;
 
   TRACE_END;
-  info.GetReturnValue().Set(Nan::New<Number>(timestamp));
+  info.GetReturnValue().Set(Nan::New<Number>(self->report.timestamp));
 }
 
 NAN_GETTER(RTCStatsReport::GetType) {
   TRACE_CALL;
 
   RTCStatsReport *self = Nan::ObjectWrap::Unwrap<RTCStatsReport>(info.Holder());
-  std::string type = self->report->type;
 
   TRACE_END;
-  info.GetReturnValue().Set(Nan::New<String>(type).ToLocalChecked());
+  info.GetReturnValue().Set(Nan::New<String>(self->report.type).ToLocalChecked());
+}
+
+Local<Value> RTCStatsReport::ToValue(const std::string& value) {
+  if (value.empty()) {
+    return Nan::New<String>(value).ToLocalChecked();
+  }
+  if ("true" == value) {
+    return Nan::True();
+  }
+  if ("false" == value) {
+    return Nan::False();
+  }
+
+  // Only plain decimal values that are numbers in their entirety are
+  // converted, so ids, addresses and codec names that happen to start with
+  // digits stay strings (as do hex, "inf" and "nan", which strtod accepts).
+  const char* begin = value.c_str();
+  if ((isdigit(static_cast<unsigned char>(*begin)) || '-' == *begin) &&
+      std::string::npos == value.find_first_of("xX")) {
+    char* end = nullptr;
+    errno = 0;
+    double number = strtod(begin, &end);
+    if (0 == errno && end == begin + value.size()) {
+      return Nan::New<Number>(number);
+    }
+  }
+  return Nan::New<String>(value).ToLocalChecked();
+}
+
+Local<Object> RTCStatsReport::ToObject(const StatsReportCopy& report) {
+  Local<Object> object = Nan::New<Object>();
+  object->Set(Nan::New("id").ToLocalChecked(), Nan::New(report.id).ToLocalChecked());
+  object->Set(Nan::New("type").ToLocalChecked(), Nan::New(report.type).ToLocalChecked());
+  object->Set(Nan::New("timestamp").ToLocalChecked(), Nan::New<Number>(report.timestamp));
+
+  const std::vector<std::pair<std::string, std::string> >& values = report.values;
+  for (std::vector<int>::size_type i = 0; i < values.size(); i++) {
+    object->Set(Nan::New(values[i].first).ToLocalChecked(), ToValue(values[i].second));
+  }
+  return object;
 }
 
 NAN_SETTER(RTCStatsReport::ReadOnly) {
@@ -117,6 +173,6 @@ void RTCStatsReport::Init(Handle<Object> exports) {
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("timestamp").ToLocalChecked(), GetTimestamp, ReadOnly);
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("type").ToLocalChecked(), GetType, ReadOnly);
 
-  constructor.Reset(tpl->GetFunction());
+  IsolateState::Current()->statsReportConstructor.Reset(tpl->GetFunction());
   exports->Set(Nan::New("RTCStatsReport").ToLocalChecked(), tpl->GetFunction());
 }
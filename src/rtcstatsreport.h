@@ -1,6 +1,11 @@
 #ifndef SRC_RTCSTATSREPORT_H_
 #define SRC_RTCSTATSREPORT_H_
 
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "nan.h"
 #include "v8.h"  // IWYU pragma: keep
 
@@ -8,17 +13,30 @@
 
 namespace node_webrtc {
 
+//
+// An owned copy of a libwebrtc StatsReport. The reports handed to
+// StatsObserver::OnComplete belong to libwebrtc's StatsCollector, which may
+// update or free them as soon as the callback returns.
+//
+struct StatsReportCopy {
+  explicit StatsReportCopy(const webrtc::StatsReport* report);
+
+  std::string id;
+  std::string type;
+  double timestamp;
+  std::vector<std::pair<std::string, std::string> > values;
+};
+
 class RTCStatsReport
 : public Nan::ObjectWrap {
  public:
-  explicit RTCStatsReport(webrtc::StatsReport* report);
+  explicit RTCStatsReport(const StatsReportCopy& report);
   ~RTCStatsReport();
 
   //
   // Nodejs wrapping.
   //
   static void Init(v8::Handle<v8::Object> exports);
-  static Nan::Persistent<v8::Function> constructor;
   static NAN_METHOD(New);
 
   static NAN_METHOD(names);
@@ -29,8 +47,23 @@ class RTCStatsReport
 
   static NAN_SETTER(ReadOnly);
 
+  // Converts |report| into a plain object ({id, type, timestamp, ...stats})
+  // in one pass, without an RTCStatsReport wrapper.
+  static v8::Local<v8::Object> ToObject(const StatsReportCopy& report);
+
+  // libwebrtc reports every value as a string; numbers and booleans are
+  // handed to JS as such, anything else stays a string.
+  static v8::Local<v8::Value> ToValue(const std::string& value);
+
  private:
-  webrtc::StatsReport* report;
+  // Builds |index| on the first stat() call.
+  void BuildIndex();
+
+  StatsReportCopy report;
+
+  // Display name -> position in |report.values|.
+  std::unordered_map<std::string, size_t> index;
+  bool indexed;
 };
 
 }  // namespace node_webrtc
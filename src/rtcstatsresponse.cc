@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "common.h"
+#include "isolate-state.h"
 #include "rtcstatsreport.h"
 
 using node_webrtc::RTCStatsResponse;
@@ -15,7 +16,6 @@ using v8::Local;
 using v8::Object;
 using v8::Value;
 
-Nan::Persistent<Function> RTCStatsResponse::constructor;
 
 NAN_METHOD(RTCStatsResponse::New) {
   TRACE_CALL;
@@ -25,9 +25,9 @@ NAN_METHOD(RTCStatsResponse::New) {
   }
 
   Local<External> _reports = Local<External>::Cast(info[0]);
-  webrtc::StatsReports* reports = static_cast<webrtc::StatsReports*>(_reports->Value());
+  std::vector<StatsReportCopy>* reports = static_cast<std::vector<StatsReportCopy>*>(_reports->Value());
 
-  RTCStatsResponse* obj = new RTCStatsResponse(*reports);
+  RTCStatsResponse* obj = new RTCStatsResponse(reports);
   obj->Wrap(info.This());
 
   TRACE_END;
@@ -41,10 +41,10 @@ NAN_METHOD(RTCStatsResponse::result) {
 
   Local<Array> reports = Nan::New<Array>(self->reports.size());
   for (std::vector<int>::size_type i = 0; i != self->reports.size(); i++) {
-    const void *copy = static_cast<const void*>(self->reports.at(i));
+    // RTCStatsReport copies the report, so the response keeps its own.
     Local<Value> cargv[1];
-    cargv[0] = Nan::New<External>(const_cast<void*>(copy));
-    reports->Set(i, Nan::New(RTCStatsReport::constructor)->NewInstance(1, cargv));
+    cargv[0] = Nan::New<External>(static_cast<void*>(&self->reports.at(i)));
+    reports->Set(i, Nan::New(IsolateState::Current()->statsReportConstructor)->NewInstance(1, cargv));
   }
 
   TRACE_END;
@@ -56,6 +56,6 @@ void RTCStatsResponse::Init(Handle<Object> exports) {
   tpl->SetClassName(Nan::New("RTCStatsResponse").ToLocalChecked());
   tpl->InstanceTemplate()->SetInternalFieldCount(1);
   Nan::SetPrototypeMethod(tpl, "result", result);
-  constructor.Reset(tpl->GetFunction());
+  IsolateState::Current()->statsResponseConstructor.Reset(tpl->GetFunction());
   exports->Set(Nan::New("RTCStatsResponse").ToLocalChecked(), tpl->GetFunction());
 }
@@ -1,30 +1,34 @@
 #ifndef SRC_RTCSTATSRESPONSE_H_
 #define SRC_RTCSTATSRESPONSE_H_
 
+#include <vector>
+
 #include "nan.h"
 #include "v8.h"  // IWYU pragma: keep
 
-#include "talk/app/webrtc/statstypes.h"
+#include "rtcstatsreport.h"
 
 namespace node_webrtc {
 
 class RTCStatsResponse
 : public Nan::ObjectWrap {
  public:
-  explicit RTCStatsResponse(webrtc::StatsReports reports): reports(reports) {}
+  // Takes the contents of |reports|, leaving it empty.
+  explicit RTCStatsResponse(std::vector<StatsReportCopy>* reports) {
+    this->reports.swap(*reports);
+  }
   ~RTCStatsResponse() {}
 
   //
   // Nodejs wrapping.
   //
   static void Init(v8::Handle<v8::Object> exports);
-  static Nan::Persistent<v8::Function> constructor;
   static NAN_METHOD(New);
 
   static NAN_METHOD(result);
 
  private:
-  webrtc::StatsReports reports;
+  std::vector<StatsReportCopy> reports;
 };
 
 }  // namespace node_webrtc
@@ -1,15 +1,39 @@
 #include "stats-observer.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "common.h"
 #include "peerconnection.h"
+#include "rtcstatsreport.h"
 
 using node_webrtc::PeerConnection;
 using node_webrtc::StatsObserver;
+using node_webrtc::StatsReportCopy;
+using node_webrtc::StatsSelector;
+
+bool StatsSelector::Matches(const webrtc::StatsReport* report) const {
+  if (!types.empty() && std::find(types.begin(), types.end(), report->type) == types.end()) {
+    return false;
+  }
+  if (!ids.empty() && std::find(ids.begin(), ids.end(), report->id) == ids.end()) {
+    return false;
+  }
+  return true;
+}
 
 void StatsObserver::OnComplete(const webrtc::StatsReports& reports) {
   TRACE_CALL;
-  webrtc::StatsReports copy = reports;
-  PeerConnection::GetStatsEvent* data = new PeerConnection::GetStatsEvent(this->callback, copy);
-  parent->QueueEvent(PeerConnection::GET_STATS_SUCCESS, static_cast<void*>(data));
+  // |reports| belongs to libwebrtc and is only valid during this call, so
+  // the matching ones are copied here; nothing else is ever converted to JS.
+  std::vector<StatsReportCopy> copies;
+  copies.reserve(reports.size());
+  for (webrtc::StatsReports::size_type i = 0; i < reports.size(); i++) {
+    if (selector.Matches(reports[i])) {
+      copies.push_back(StatsReportCopy(reports[i]));
+    }
+  }
+  PeerConnection::GetStatsEvent* data = new PeerConnection::GetStatsEvent(this->callback, &copies, this->plain);
+  parent->QueueEvent(PeerConnection::GET_STATS_SUCCESS, data);
   TRACE_END;
 }
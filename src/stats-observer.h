@@ -1,6 +1,9 @@
 #ifndef SRC_STATS_OBSERVER_H_
 #define SRC_STATS_OBSERVER_H_
 
+#include <string>
+#include <vector>
+
 #include "nan.h"  // IWYU pragma: keep
 
 #include "talk/app/webrtc/peerconnectioninterface.h"
@@ -10,15 +13,29 @@ namespace node_webrtc {
 
 class PeerConnection;
 
+//
+// Restricts a getStats call to reports of the given types and/or ids. Empty
+// lists match everything.
+//
+struct StatsSelector {
+  std::vector<std::string> types;
+  std::vector<std::string> ids;
+
+  bool Matches(const webrtc::StatsReport* report) const;
+};
+
 class StatsObserver
 : public webrtc::StatsObserver {
  private:
   PeerConnection* parent;
   Nan::Callback* callback;
+  bool plain;
+  StatsSelector selector;
 
  public:
-  explicit StatsObserver(PeerConnection* parent, Nan::Callback *callback)
-  : parent(parent), callback(callback) {}
+  StatsObserver(PeerConnection* parent, Nan::Callback *callback, bool plain = false,
+                const StatsSelector& selector = StatsSelector())
+  : parent(parent), callback(callback), plain(plain), selector(selector) {}
 
   virtual void OnComplete(const webrtc::StatsReports& reports);
 };
@@ -0,0 +1,499 @@
+#include "stats-sampler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "talk/app/webrtc/peerconnectioninterface.h"
+#include "webrtc/base/refcount.h"
+#include "webrtc/base/thread.h"
+
+#include "common.h"
+#include "isolate-state.h"
+#include "peerconnection.h"
+#include "peerconnectionfactory.h"
+
+using node_webrtc::PeerConnection;
+using node_webrtc::StatsSampler;
+using v8::Array;
+using v8::Function;
+using v8::FunctionTemplate;
+using v8::Handle;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+using v8::String;
+using v8::Uint32;
+using v8::Value;
+
+// Display names of the counters, in Counter order.
+static const char* kCounterNames[StatsSampler::COUNTER_COUNT] = {
+  "bytesSent",
+  "bytesReceived",
+  "packetsSent",
+  "packetsReceived",
+  "packetsLost"
+};
+
+// Periods a tick may wait on slow peers before it is abandoned.
+static const uint32_t kTickDeadlinePeriods = 4;
+
+static const char* kRateNames[StatsSampler::COUNTER_COUNT] = {
+  "bytesSentPerSecond",
+  "bytesReceivedPerSecond",
+  "packetsSentPerSecond",
+  "packetsReceivedPerSecond",
+  "packetsLostPerSecond"
+};
+
+namespace node_webrtc {
+
+//
+// Reduces a GetStats result to one Sample on the signaling thread. Data
+// channels carry everything over the active candidate pair, so that report
+// alone holds the connection's totals and round-trip time.
+//
+class SamplerStatsObserver
+: public webrtc::StatsObserver {
+ public:
+  SamplerStatsObserver(StatsSampler* sampler, uint32_t peer, uint32_t generation)
+  : _sampler(sampler), _peer(peer), _generation(generation) {}
+
+  virtual void OnComplete(const webrtc::StatsReports& reports) {
+    TRACE_CALL;
+    StatsSampler::Sample* sample = new StatsSampler::Sample(_peer, _generation);
+    sample->time = uv_hrtime();
+
+    for (webrtc::StatsReports::size_type i = 0; i < reports.size(); i++) {
+      const webrtc::StatsReport* report = reports[i];
+      if ("googCandidatePair" != report->type) {
+        continue;
+      }
+
+      const webrtc::StatsReport::Values& values = report->values;
+      bool active = false;
+      for (webrtc::StatsReport::Values::size_type j = 0; j < values.size(); j++) {
+        if (!strcmp(values[j].display_name(), "googActiveConnection")) {
+          active = "true" == values[j].value;
+          break;
+        }
+      }
+      if (!active) {
+        continue;
+      }
+
+      for (webrtc::StatsReport::Values::size_type j = 0; j < values.size(); j++) {
+        const char* name = values[j].display_name();
+        if (!strcmp(name, "googRtt")) {
+          sample->rtt = strtod(values[j].value.c_str(), nullptr);
+          continue;
+        }
+        for (int k = 0; k < StatsSampler::COUNTER_COUNT; k++) {
+          if (!strcmp(name, kCounterNames[k])) {
+            sample->counters[k] += strtod(values[j].value.c_str(), nullptr);
+            break;
+          }
+        }
+      }
+      sample->valid = true;
+    }
+
+    _sampler->QueueSample(sample);
+    TRACE_END;
+  }
+
+ private:
+  StatsSampler* _sampler;
+  uint32_t _peer;
+  uint32_t _generation;
+};
+
+//
+// The requests of one tick for the peers that share a signaling thread.
+//
+struct SamplerStatsRequests
+: public rtc::MessageData {
+  explicit SamplerStatsRequests(uint32_t generation)
+  : generation(generation) {}
+
+  uint32_t generation;
+  std::vector<std::pair<uint32_t, rtc::scoped_refptr<webrtc::PeerConnectionInterface> > > connections;
+};
+
+}  // namespace node_webrtc
+
+using node_webrtc::SamplerStatsObserver;
+using node_webrtc::SamplerStatsRequests;
+
+StatsSampler::Sample::Sample(uint32_t peer, uint32_t generation)
+: peer(peer), generation(generation), time(0), valid(false), rtt(-1) {
+  for (int i = 0; i < COUNTER_COUNT; i++) {
+    counters[i] = 0;
+  }
+}
+
+StatsSampler::StatsSampler(uint32_t period)
+: _dispatcher(IsolateState::Current()->dispatcher()),
+  _timer(new uv_timer_t),
+  _period(period),
+  _running(false),
+  _nextId(0),
+  _generation(0),
+  _pending(0),
+  _outstanding(0),
+  _tickStarted(0) {
+  uv_timer_init(Nan::GetCurrentEventLoop(), _timer);
+  uv_unref(reinterpret_cast<uv_handle_t*>(_timer));
+  _timer->data = this;
+}
+
+StatsSampler::~StatsSampler() {
+  TRACE_CALL;
+  _dispatcher->Cancel(this);
+
+  uv_timer_stop(_timer);
+  _timer->data = nullptr;
+  uv_close(reinterpret_cast<uv_handle_t*>(_timer), CloseTimer);
+
+  for (std::unordered_map<uint32_t, Peer*>::iterator it = _peers.begin(); it != _peers.end(); ++it) {
+    it->second->handle.Reset();
+    delete it->second;
+  }
+
+  std::vector<Sample*> samples;
+  _samples.Swap(&samples);
+  for (std::vector<Sample*>::size_type i = 0; i < samples.size(); i++) {
+    delete samples[i];
+  }
+  TRACE_END;
+}
+
+void StatsSampler::CloseTimer(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_timer_t*>(handle);
+}
+
+void StatsSampler::QueueSample(Sample* sample) {
+  if (_samples.Push(sample)) {
+    _dispatcher->Schedule(this);
+  }
+}
+
+void StatsSampler::OnMessage(rtc::Message* msg) {
+  TRACE_CALL;
+  SamplerStatsRequests* requests = static_cast<SamplerStatsRequests*>(msg->pdata);
+  for (std::vector<int>::size_type i = 0; i < requests->connections.size(); i++) {
+    uint32_t peer = requests->connections[i].first;
+    rtc::scoped_refptr<SamplerStatsObserver> observer =
+        new rtc::RefCountedObject<SamplerStatsObserver>(this, peer, requests->generation);
+    if (!requests->connections[i].second->GetStats(observer,
+            webrtc::PeerConnectionInterface::kStatsOutputLevelStandard)) {
+      // Reported anyway, so the tick is not left waiting on this peer.
+      QueueSample(new Sample(peer, requests->generation));
+    }
+  }
+  delete requests;
+  TRACE_END;
+}
+
+void StatsSampler::Tick(uv_timer_t* handle, int status) {
+  StatsSampler* self = static_cast<StatsSampler*>(handle->data);
+  TRACE_CALL_P((uintptr_t)self);
+
+  // A tick still waiting on slow peers is not overlapped with a new one,
+  // unless it is past its deadline: then whatever it is still waiting for is
+  // dropped on arrival.
+  if (self->_pending) {
+    uint64_t deadline = static_cast<uint64_t>(self->_period) * kTickDeadlinePeriods * 1000000;
+    if (uv_hrtime() - self->_tickStarted < deadline) {
+      TRACE_END;
+      return;
+    }
+    self->_pending = 0;
+  }
+  self->_generation++;
+  self->_tickStarted = uv_hrtime();
+  uint32_t outstanding = self->_outstanding;
+
+  // Calling GetStats through the proxy from here would block on a round
+  // trip to the signaling thread per peer. Instead the requests are grouped
+  // by signaling thread and posted there in one message each; every request
+  // reports back through QueueSample, whether or not it was started.
+  std::unordered_map<rtc::Thread*, SamplerStatsRequests*> requests;
+  for (std::unordered_map<uint32_t, Peer*>::iterator it = self->_peers.begin(); it != self->_peers.end(); ++it) {
+    PeerConnection* connection = it->second->connection;
+    if (!connection->jinglePeerConnection() || !connection->factory()) {
+      continue;
+    }
+    SamplerStatsRequests*& request = requests[connection->factory()->signalingThread()];
+    if (!request) {
+      request = new SamplerStatsRequests(self->_generation);
+    }
+    request->connections.push_back(std::make_pair(it->first,
+        rtc::scoped_refptr<webrtc::PeerConnectionInterface>(connection->jinglePeerConnection())));
+    self->_pending++;
+    self->_outstanding++;
+  }
+
+  // Keep the sampler alive until every observer has reported back.
+  if (!outstanding && self->_outstanding) {
+    self->Ref();
+  }
+
+  for (std::unordered_map<rtc::Thread*, SamplerStatsRequests*>::iterator it = requests.begin(); it != requests.end(); ++it) {
+    it->first->Post(self, 0, it->second);
+  }
+
+  TRACE_END;
+}
+
+void StatsSampler::Run() {
+  Nan::HandleScope scope;
+  StatsSampler* self = this;
+  TRACE_CALL_P((uintptr_t)self);
+
+  self->_samples.Swap(&self->_batch);
+  for (std::vector<Sample*>::size_type i = 0; i < self->_batch.size(); i++) {
+    Sample* sample = self->_batch[i];
+
+    bool current = sample->generation == self->_generation;
+
+    // Samples for peers removed since the tick started, and samples from an
+    // abandoned tick, are dropped.
+    std::unordered_map<uint32_t, Peer*>::iterator it = self->_peers.find(sample->peer);
+    if (current && it != self->_peers.end() && sample->valid) {
+      Peer* peer = it->second;
+      if (peer->sampled) {
+        peer->hasPrevious = true;
+        peer->previousTime = peer->time;
+        memcpy(peer->previous, peer->counters, sizeof(peer->counters));
+      }
+      peer->sampled = true;
+      peer->time = sample->time;
+      memcpy(peer->counters, sample->counters, sizeof(peer->counters));
+      peer->rtt = sample->rtt;
+    }
+    delete sample;
+
+    if (current && self->_pending && 0 == --self->_pending) {
+      self->Emit();
+    }
+    if (0 == --self->_outstanding) {
+      self->Unref();
+    }
+  }
+  self->_batch.clear();
+
+  TRACE_END;
+}
+
+void StatsSampler::Emit() {
+  if (_onTick.IsEmpty()) {
+    return;
+  }
+
+  Local<Array> peers = Nan::New<Array>();
+  double totals[COUNTER_COUNT] = {0};
+  double rates[COUNTER_COUNT] = {0};
+  double rtt_sum = 0;
+  uint32_t rtt_count = 0;
+  uint32_t count = 0;
+
+  for (std::vector<uint32_t>::size_type i = 0; i < _order.size(); i++) {
+    Peer* peer = _peers[_order[i]];
+    if (!peer->sampled) {
+      continue;
+    }
+
+    Local<Object> entry = Nan::New<Object>();
+    entry->Set(Nan::New("label").ToLocalChecked(), Nan::New(peer->label).ToLocalChecked());
+
+    double seconds = peer->hasPrevious ? (peer->time - peer->previousTime) / 1e9 : 0;
+    for (int k = 0; k < COUNTER_COUNT; k++) {
+      entry->Set(Nan::New(kCounterNames[k]).ToLocalChecked(), Nan::New<Number>(peer->counters[k]));
+      totals[k] += peer->counters[k];
+
+      // Counters restart when a new candidate pair becomes active; a drop is
+      // reported as no traffic rather than as a negative rate.
+      double rate = 0;
+      if (seconds > 0) {
+        rate = std::max(0.0, (peer->counters[k] - peer->previous[k]) / seconds);
+      }
+      entry->Set(Nan::New(kRateNames[k]).ToLocalChecked(), Nan::New<Number>(rate));
+      rates[k] += rate;
+    }
+
+    if (peer->rtt >= 0) {
+      entry->Set(Nan::New("rtt").ToLocalChecked(), Nan::New<Number>(peer->rtt));
+      rtt_sum += peer->rtt;
+      rtt_count++;
+    }
+    peers->Set(count++, entry);
+  }
+
+  Local<Object> total = Nan::New<Object>();
+  for (int k = 0; k < COUNTER_COUNT; k++) {
+    total->Set(Nan::New(kCounterNames[k]).ToLocalChecked(), Nan::New<Number>(totals[k]));
+    total->Set(Nan::New(kRateNames[k]).ToLocalChecked(), Nan::New<Number>(rates[k]));
+  }
+  if (rtt_count) {
+    total->Set(Nan::New("rtt").ToLocalChecked(), Nan::New<Number>(rtt_sum / rtt_count));
+  }
+
+  Local<Object> snapshot = Nan::New<Object>();
+  snapshot->Set(Nan::New("timestamp").ToLocalChecked(), Nan::New<Number>(uv_hrtime() / 1e6));
+  snapshot->Set(Nan::New("peers").ToLocalChecked(), peers);
+  snapshot->Set(Nan::New("total").ToLocalChecked(), total);
+
+  Local<Value> argv[1];
+  argv[0] = snapshot;
+  _onTick.Call(handle(), 1, argv);
+}
+
+static bool IsPeerConnection(Local<Value> value) {
+  return Nan::New(node_webrtc::IsolateState::Current()->peerConnectionTemplate)->HasInstance(value);
+}
+
+NAN_METHOD(StatsSampler::New) {
+  TRACE_CALL;
+
+  if (!info.IsConstructCall()) {
+    return Nan::ThrowTypeError("Use the new operator to construct the StatsSampler.");
+  }
+
+  uint32_t period = info[0]->IsNumber() ? info[0]->Uint32Value() : 1000;
+  if (!period) {
+    return Nan::ThrowRangeError("The sampling period must be at least 1 ms");
+  }
+
+  StatsSampler* obj = new StatsSampler(period);
+  obj->Wrap(info.This());
+
+  TRACE_END;
+  info.GetReturnValue().Set(info.This());
+}
+
+NAN_METHOD(StatsSampler::Add) {
+  TRACE_CALL;
+
+  StatsSampler* self = Nan::ObjectWrap::Unwrap<StatsSampler>(info.This());
+
+  if (!IsPeerConnection(info[0])) {
+    return Nan::ThrowTypeError("Argument 0 must be a PeerConnection");
+  }
+  Local<Object> handle = info[0].As<Object>();
+
+  Peer* peer = new Peer();
+  peer->id = self->_nextId++;
+  peer->connection = Nan::ObjectWrap::Unwrap<PeerConnection>(handle);
+  peer->handle.Reset(handle);
+  peer->sampled = false;
+  peer->hasPrevious = false;
+  peer->rtt = -1;
+  if (info[1]->IsString()) {
+    peer->label = *String::Utf8Value(info[1]->ToString());
+  } else {
+    peer->label = std::to_string(peer->id);
+  }
+
+  self->_peers[peer->id] = peer;
+  self->_order.push_back(peer->id);
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::New<Uint32>(peer->id));
+}
+
+NAN_METHOD(StatsSampler::Remove) {
+  TRACE_CALL;
+
+  StatsSampler* self = Nan::ObjectWrap::Unwrap<StatsSampler>(info.This());
+  bool removed = false;
+
+  if (IsPeerConnection(info[0])) {
+    PeerConnection* connection = Nan::ObjectWrap::Unwrap<PeerConnection>(info[0].As<Object>());
+    for (std::vector<uint32_t>::size_type i = 0; i < self->_order.size(); i++) {
+      Peer* peer = self->_peers[self->_order[i]];
+      if (peer->connection == connection) {
+        self->_peers.erase(peer->id);
+        self->_order.erase(self->_order.begin() + i);
+        peer->handle.Reset();
+        delete peer;
+        removed = true;
+        break;
+      }
+    }
+  }
+
+  TRACE_END;
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(removed));
+}
+
+NAN_METHOD(StatsSampler::Start) {
+  TRACE_CALL;
+
+  StatsSampler* self = Nan::ObjectWrap::Unwrap<StatsSampler>(info.This());
+  if (!self->_running) {
+    self->_running = true;
+    uv_timer_start(self->_timer, reinterpret_cast<uv_timer_cb>(Tick), self->_period, self->_period);
+  }
+
+  TRACE_END;
+  return;
+}
+
+NAN_METHOD(StatsSampler::Stop) {
+  TRACE_CALL;
+
+  StatsSampler* self = Nan::ObjectWrap::Unwrap<StatsSampler>(info.This());
+  if (self->_running) {
+    self->_running = false;
+    uv_timer_stop(self->_timer);
+  }
+
+  TRACE_END;
+  return;
+}
+
+NAN_GETTER(StatsSampler::GetPeriod) {
+  StatsSampler* self = Nan::ObjectWrap::Unwrap<StatsSampler>(info.Holder());
+  info.GetReturnValue().Set(Nan::New<Uint32>(self->_period));
+}
+
+NAN_GETTER(StatsSampler::GetOnTick) {
+  StatsSampler* self = Nan::ObjectWrap::Unwrap<StatsSampler>(info.Holder());
+  if (self->_onTick.IsEmpty()) {
+    info.GetReturnValue().Set(Nan::Null());
+  } else {
+    info.GetReturnValue().Set(self->_onTick.GetFunction());
+  }
+}
+
+NAN_SETTER(StatsSampler::SetOnTick) {
+  StatsSampler* self = Nan::ObjectWrap::Unwrap<StatsSampler>(info.Holder());
+  if (value->IsFunction()) {
+    self->_onTick.Reset(value.As<Function>());
+  } else {
+    self->_onTick.Reset();
+  }
+}
+
+NAN_SETTER(StatsSampler::ReadOnly) {
+  INFO("StatsSampler::ReadOnly");
+}
+
+void StatsSampler::Init(Handle<Object> exports) {
+  Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+  tpl->SetClassName(Nan::New("StatsSampler").ToLocalChecked());
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  Nan::SetPrototypeMethod(tpl, "add", Add);
+  Nan::SetPrototypeMethod(tpl, "remove", Remove);
+  Nan::SetPrototypeMethod(tpl, "start", Start);
+  Nan::SetPrototypeMethod(tpl, "stop", Stop);
+
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("period").ToLocalChecked(), GetPeriod, ReadOnly);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("ontick").ToLocalChecked(), GetOnTick, SetOnTick);
+
+  exports->Set(Nan::New("StatsSampler").ToLocalChecked(), tpl->GetFunction());
+}
@@ -0,0 +1,132 @@
+#ifndef SRC_STATS_SAMPLER_H_
+#define SRC_STATS_SAMPLER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nan.h"
+#include "uv.h"
+#include "v8.h"  // IWYU pragma: keep
+
+#include "talk/app/webrtc/statstypes.h"
+#include "webrtc/base/messagehandler.h"
+
+#include "async-dispatcher.h"
+#include "buffer-pool.h"
+#include "event-queue.h"
+
+namespace node_webrtc {
+
+class PeerConnection;
+
+//
+// Periodically runs GetStats on a set of PeerConnections and reduces each
+// result to a handful of counters on the signaling thread. Once every
+// request of a tick has completed, deltas and per-second rates are computed
+// on the Node thread and handed to ontick as one snapshot, so JS sees one
+// small object per tick instead of a report tree per peer. A tick only posts
+// its requests to the peers' signaling threads; it never waits on them.
+//
+class StatsSampler
+: public Nan::ObjectWrap
+, public AsyncDispatcher::Target
+, public rtc::MessageHandler {
+ public:
+  enum Counter {
+    BYTES_SENT,
+    BYTES_RECEIVED,
+    PACKETS_SENT,
+    PACKETS_RECEIVED,
+    PACKETS_LOST,
+    COUNTER_COUNT
+  };
+
+  struct Sample : public Pooled {
+    Sample(uint32_t peer, uint32_t generation);
+
+    uint32_t peer;
+    uint32_t generation;  // the tick that requested it
+    uint64_t time;  // uv_hrtime() when the stats arrived
+    bool valid;     // false if no active candidate pair was reported
+    double counters[COUNTER_COUNT];
+    double rtt;     // milliseconds, negative if unknown
+  };
+
+  explicit StatsSampler(uint32_t period);
+  ~StatsSampler();
+
+  // Called from the signaling thread by the sampler's StatsObserver.
+  void QueueSample(Sample* sample);
+
+  // Runs on a signaling thread: starts the GetStats requests a tick posted
+  // there.
+  virtual void OnMessage(rtc::Message* msg);
+
+  //
+  // Nodejs wrapping.
+  //
+  static void Init(v8::Handle<v8::Object> exports);
+  static NAN_METHOD(New);
+
+  static NAN_METHOD(Add);
+  static NAN_METHOD(Remove);
+  static NAN_METHOD(Start);
+  static NAN_METHOD(Stop);
+
+  static NAN_GETTER(GetPeriod);
+  static NAN_GETTER(GetOnTick);
+  static NAN_SETTER(SetOnTick);
+  static NAN_SETTER(ReadOnly);
+
+ private:
+  struct Peer {
+    uint32_t id;
+    std::string label;
+    PeerConnection* connection;
+    Nan::Persistent<v8::Object> handle;
+
+    // Last sample, and the one before it for rates.
+    bool sampled;
+    bool hasPrevious;
+    uint64_t time;
+    uint64_t previousTime;
+    double counters[COUNTER_COUNT];
+    double previous[COUNTER_COUNT];
+    double rtt;
+  };
+
+  static void Tick(uv_timer_t* handle, int status);
+  static void CloseTimer(uv_handle_t* handle);
+
+  virtual void Run();
+  void Emit();
+
+  AsyncDispatcher* _dispatcher;
+  uv_timer_t* _timer;
+  uint32_t _period;
+  bool _running;
+
+  // Node thread only. |_pending| counts the current tick's outstanding
+  // requests; a tick that has not completed within a few periods is
+  // abandoned by moving on to the next |_generation|, and its samples are
+  // dropped when they arrive. |_outstanding| counts the requests of every
+  // generation, since each observer points back at the sampler.
+  uint32_t _nextId;
+  uint32_t _generation;
+  uint32_t _pending;
+  uint32_t _outstanding;
+  uint64_t _tickStarted;
+  std::unordered_map<uint32_t, Peer*> _peers;
+  std::vector<uint32_t> _order;
+  Nan::Callback _onTick;
+
+  EventQueue<Sample*> _samples;
+  std::vector<Sample*> _batch;
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_STATS_SAMPLER_H_
@@ -0,0 +1,198 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "uv.h"
+
+using node_webrtc::Trace;
+using v8::FunctionTemplate;
+using v8::Handle;
+using v8::Object;
+
+// 32 bytes per record, so 512 KiB per tracing thread.
+static const uint32_t kRingSize = 16384;
+
+struct TraceRecord {
+  uint64_t timestamp;
+  const char* name;
+  uint64_t arg;
+  char phase;
+};
+
+struct TraceRing {
+  uint32_t tid;
+  const char* threadName;
+
+  // Total records written; the newest is at (head - 1) % kRingSize. Only the
+  // owning thread writes it.
+  std::atomic<uint64_t> head;
+
+  // |head| as of the last Clear(); older records are left out of exports.
+  // Only Clear() writes it, so clearing never races with the owner.
+  std::atomic<uint64_t> clearedAt;
+  TraceRecord records[kRingSize];
+};
+
+std::atomic<bool> Trace::_enabled(
+#if defined(TRACING)
+    true
+#else
+    false
+#endif
+);
+
+// Rings are registered once and never freed: libwebrtc threads may record
+// right up until the process exits.
+static uv_once_t once = UV_ONCE_INIT;
+static uv_mutex_t ringsLock;
+static std::vector<TraceRing*>* rings;
+
+static __thread TraceRing* currentRing = nullptr;
+
+// Kept apart from the ring so naming a thread does not allocate one.
+static __thread const char* currentThreadName = nullptr;
+
+static void InitRings() {
+  uv_mutex_init(&ringsLock);
+  rings = new std::vector<TraceRing*>();
+}
+
+static TraceRing* CurrentRing() {
+  if (!currentRing) {
+    uv_once(&once, InitRings);
+    TraceRing* ring = new TraceRing();
+    ring->threadName = currentThreadName;
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->clearedAt.store(0, std::memory_order_relaxed);
+
+    uv_mutex_lock(&ringsLock);
+    ring->tid = static_cast<uint32_t>(rings->size() + 1);
+    rings->push_back(ring);
+    uv_mutex_unlock(&ringsLock);
+
+    currentRing = ring;
+  }
+  return currentRing;
+}
+
+void Trace::SetEnabled(bool enabled) {
+  _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Trace::Record(Phase phase, const char* name, uint64_t arg) {
+  TraceRing* ring = CurrentRing();
+  uint64_t head = ring->head.load(std::memory_order_relaxed);
+
+  TraceRecord* record = &ring->records[head % kRingSize];
+  record->timestamp = uv_hrtime();
+  record->name = name;
+  record->arg = arg;
+  record->phase = static_cast<char>(phase);
+
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Trace::SetThreadName(const char* name) {
+  currentThreadName = name;
+  if (currentRing) {
+    currentRing->threadName = name;
+  }
+}
+
+static void AppendEscaped(std::string* out, const char* str) {
+  for (; *str; str++) {
+    if ('"' == *str || '\\' == *str) {
+      out->push_back('\\');
+    }
+    if (static_cast<unsigned char>(*str) >= 0x20) {
+      out->push_back(*str);
+    }
+  }
+}
+
+std::string Trace::Export() {
+  uv_once(&once, InitRings);
+  uv_mutex_lock(&ringsLock);
+  std::vector<TraceRing*> all(*rings);
+  uv_mutex_unlock(&ringsLock);
+
+  int pid = static_cast<int>(getpid());
+  std::string out = "{\"traceEvents\":[";
+  bool first = true;
+  char buffer[128];
+
+  for (std::vector<TraceRing*>::size_type i = 0; i < all.size(); i++) {
+    TraceRing* ring = all[i];
+
+    if (ring->threadName) {
+      snprintf(buffer, sizeof(buffer),
+          "%s{\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"",
+          first ? "" : ",", pid, ring->tid);
+      out += buffer;
+      AppendEscaped(&out, ring->threadName);
+      out += "\"}}";
+      first = false;
+    }
+
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t start = head > kRingSize ? head - kRingSize : 0;
+    uint64_t cleared = ring->clearedAt.load(std::memory_order_relaxed);
+    if (start < cleared) {
+      start = cleared;
+    }
+    for (uint64_t j = start; j < head; j++) {
+      const TraceRecord& record = ring->records[j % kRingSize];
+      snprintf(buffer, sizeof(buffer),
+          "%s{\"ph\":\"%c\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,",
+          first ? "" : ",", record.phase, pid, ring->tid, record.timestamp / 1e3);
+      out += buffer;
+      if (Trace::INSTANT == record.phase) {
+        out += "\"s\":\"t\",";
+      }
+      out += "\"name\":\"";
+      AppendEscaped(&out, record.name);
+      snprintf(buffer, sizeof(buffer), "\",\"args\":{\"arg\":%llu}}",
+          static_cast<unsigned long long>(record.arg));
+      out += buffer;
+      first = false;
+    }
+  }
+
+  out += "]}";
+  return out;
+}
+
+void Trace::Clear() {
+  uv_once(&once, InitRings);
+  uv_mutex_lock(&ringsLock);
+  for (std::vector<TraceRing*>::size_type i = 0; i < rings->size(); i++) {
+    TraceRing* ring = (*rings)[i];
+    ring->clearedAt.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+  uv_mutex_unlock(&ringsLock);
+}
+
+NAN_METHOD(Trace::SetTracing) {
+  bool enabled = info[0]->BooleanValue();
+  if (enabled && !Trace::enabled()) {
+    Clear();
+  }
+  SetEnabled(enabled);
+}
+
+NAN_METHOD(Trace::GetTrace) {
+  std::string trace = Export();
+  info.GetReturnValue().Set(Nan::New(trace.c_str(), trace.size()).ToLocalChecked());
+}
+
+void Trace::Init(Handle<Object> exports) {
+  SetThreadName("node");
+  exports->Set(Nan::New("setTracing").ToLocalChecked(),
+      Nan::New<FunctionTemplate>(SetTracing)->GetFunction());
+  exports->Set(Nan::New("getTrace").ToLocalChecked(),
+      Nan::New<FunctionTemplate>(GetTrace)->GetFunction());
+}
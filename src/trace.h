@@ -0,0 +1,91 @@
+#ifndef SRC_TRACE_H_
+#define SRC_TRACE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "nan.h"
+#include "v8.h"  // IWYU pragma: keep
+
+namespace node_webrtc {
+
+//
+// Per-thread binary trace rings behind the TRACE_* macros in common.h.
+//
+// Each thread that records gets its own fixed-size ring on first use, so
+// recording never takes a lock. A record holds only a timestamp, a phase, a
+// pointer to a string literal and one integer argument. When tracing is off
+// a TRACE_* macro costs one relaxed load.
+//
+// Export() walks every ring and renders Chrome trace-event JSON, for
+// chrome://tracing or Perfetto. Threads may still be recording while it
+// runs, so records overwritten mid-export can come out garbled; call
+// SetEnabled(false) first for an exact snapshot.
+//
+class Trace {
+ public:
+  enum Phase {
+    BEGIN = 'B',
+    END = 'E',
+    INSTANT = 'i'
+  };
+
+  static bool enabled() {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+
+  static void SetEnabled(bool enabled);
+
+  // |name| must outlive the trace, e.g. a string literal or __PRETTY_FUNCTION__.
+  static void Record(Phase phase, const char* name, uint64_t arg);
+
+  // Names the calling thread in exported traces. |name| must outlive the
+  // trace.
+  static void SetThreadName(const char* name);
+
+  static std::string Export();
+  static void Clear();
+
+  //
+  // Nodejs wrapping.
+  //
+  static void Init(v8::Handle<v8::Object> exports);
+  static NAN_METHOD(SetTracing);
+  static NAN_METHOD(GetTrace);
+
+ private:
+  static std::atomic<bool> _enabled;
+};
+
+//
+// Records BEGIN on construction and END on End() or destruction, whichever
+// comes first, so that early returns still close the slice. Nothing is
+// recorded for a scope entered while tracing was off.
+//
+class TraceScope {
+ public:
+  TraceScope(const char* name, uint64_t arg)
+  : _name(Trace::enabled() ? name : nullptr) {
+    if (_name) {
+      Trace::Record(Trace::BEGIN, _name, arg);
+    }
+  }
+
+  ~TraceScope() { End(); }
+
+  void End() {
+    if (_name) {
+      Trace::Record(Trace::END, _name, 0);
+      _name = nullptr;
+    }
+  }
+
+ private:
+  const char* _name;
+};
+
+}  // namespace node_webrtc
+
+#endif  // SRC_TRACE_H_
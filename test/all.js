@@ -1,5 +1,8 @@
 require('./create-offer');
 require('./sessiondesc');
 require('./connect');
+require('./factory-pool');
+require('./datachannelstream');
+require('./worker');
 //require('./bwtest').tape();
 //require('./multiconnect');
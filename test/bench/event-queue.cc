@@ -0,0 +1,139 @@
+// Microbenchmark for the native event queue.
+//
+// Compares the previous scheme (uv_mutex_t + std::queue, one lock per pushed
+// and per popped event) with EventQueue (one lock per push, one lock per
+// drained batch). Producers stand in for libwebrtc threads, the consumer for
+// the Node thread draining events in Run().
+//
+// Build and run from the repository root:
+//
+//   g++ -O2 -std=c++11 -pthread -Isrc -I<node include dir> -o event-queue-bench
+//     test/bench/event-queue.cc -luv
+//   ./event-queue-bench [producers] [events per producer]
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <queue>
+#include <vector>
+
+#include "uv.h"
+
+#include "event-queue.h"
+
+struct Event {
+  int type;
+  void* data;
+};
+
+class LegacyQueue {
+ public:
+  LegacyQueue() { uv_mutex_init(&_lock); }
+  ~LegacyQueue() { uv_mutex_destroy(&_lock); }
+
+  void Push(const Event& evt) {
+    uv_mutex_lock(&_lock);
+    _events.push(evt);
+    uv_mutex_unlock(&_lock);
+  }
+
+  uint64_t Drain() {
+    uint64_t count = 0;
+    while (true) {
+      uv_mutex_lock(&_lock);
+      bool empty = _events.empty();
+      if (empty) {
+        uv_mutex_unlock(&_lock);
+        break;
+      }
+      Event evt = _events.front();
+      _events.pop();
+      uv_mutex_unlock(&_lock);
+      count += evt.type;
+    }
+    return count;
+  }
+
+ private:
+  uv_mutex_t _lock;
+  std::queue<Event> _events;
+};
+
+class BatchQueue {
+ public:
+  void Push(const Event& evt) {
+    _events.Push(evt);
+  }
+
+  uint64_t Drain() {
+    uint64_t count = 0;
+    _events.Swap(&_batch);
+    for (std::vector<Event>::size_type i = 0; i < _batch.size(); i++) {
+      count += _batch[i].type;
+    }
+    _batch.clear();
+    return count;
+  }
+
+ private:
+  node_webrtc::EventQueue<Event> _events;
+  std::vector<Event> _batch;
+};
+
+template <typename Q>
+struct Producer {
+  Q* queue;
+  uint64_t count;
+
+  static void Run(void* arg) {
+    Producer* self = static_cast<Producer*>(arg);
+    Event evt = { 1, nullptr };
+    for (uint64_t i = 0; i < self->count; i++) {
+      self->queue->Push(evt);
+    }
+  }
+};
+
+template <typename Q>
+static double Bench(int producers, uint64_t count) {
+  Q queue;
+  std::vector<Producer<Q> > args(producers);
+  std::vector<uv_thread_t> threads(producers);
+
+  uint64_t start = uv_hrtime();
+  for (int i = 0; i < producers; i++) {
+    args[i].queue = &queue;
+    args[i].count = count;
+    uv_thread_create(&threads[i], Producer<Q>::Run, &args[i]);
+  }
+
+  uint64_t total = count * producers;
+  uint64_t drained = 0;
+  while (drained < total) {
+    drained += queue.Drain();
+  }
+
+  for (int i = 0; i < producers; i++) {
+    uv_thread_join(&threads[i]);
+  }
+  uint64_t elapsed = uv_hrtime() - start;
+
+  return static_cast<double>(total) / (static_cast<double>(elapsed) / 1e9);
+}
+
+int main(int argc, char** argv) {
+  int producers = argc > 1 ? atoi(argv[1]) : 1;
+  uint64_t count = argc > 2 ? strtoull(argv[2], nullptr, 10) : 5000000;
+
+  printf("producers: %d, events per producer: %llu\n",
+      producers, static_cast<unsigned long long>(count));
+
+  double legacy = Bench<LegacyQueue>(producers, count);
+  printf("mutex + std::queue: %12.0f events/s\n", legacy);
+
+  double batch = Bench<BatchQueue>(producers, count);
+  printf("EventQueue (swap):  %12.0f events/s (%.2fx)\n", batch, batch / legacy);
+
+  return 0;
+}
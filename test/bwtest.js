@@ -99,6 +99,7 @@ function bwtest(options, callback) {
 
     var n = 0;
     var congested = 0;
+    var buffer = new ArrayBuffer(options.packetSize);
     var stats = {
         startTime: 0,
         count: 0,
@@ -152,12 +153,9 @@ function bwtest(options, callback) {
             console.log('SENDING:', info());
         }
         if (congestion()) {
-            setTimeout(send, options.bufferedDelayMs);
+            waitForDrain();
             return;
         }
-        // TODO allocating new buffer per send as workaround to repeated Externalize()
-        // after fixing the issues around that we can move back to higher scope.
-        var buffer = new ArrayBuffer(options.packetSize);
         peer1.send(buffer, function(err) {
             if (err) {
                 return failure(err);
@@ -225,6 +223,24 @@ function bwtest(options, callback) {
 
 
 
+    /**
+     * resume sending once the channel reports it drained below the low
+     * threshold, falling back to polling when the event is unavailable
+     */
+    function waitForDrain() {
+        var channel = peer1._channel;
+        if (!channel || !('bufferedAmountLowThreshold' in channel)) {
+            setTimeout(send, options.bufferedDelayMs);
+            return;
+        }
+        channel.bufferedAmountLowThreshold = options.congestLowThreshold;
+        channel.onbufferedamountlow = function() {
+            channel.onbufferedamountlow = null;
+            send();
+        };
+    }
+
+
     /**
      * return information string on the test progress
      */
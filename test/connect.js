@@ -200,6 +200,332 @@ test('data channel connectivity', function(t) {
   t.pass('successfully called send on dc:0');
 });
 
+test('data channel sends a slice without detaching its buffer', function(t) {
+  var backing = new Uint8Array([1, 2, 3, 4, 5, 6]);
+  var slice = backing.subarray(2, 4);
+
+  t.plan(4);
+  dcs[1].onmessage = function(evt) {
+    var data = new Uint8Array(evt.data);
+    t.equal(data.length, 2, 'only the slice was sent');
+    t.equal(data[0], 3, 'byte:0 matches expected');
+    t.equal(data[1], 4, 'byte:1 matches expected');
+  };
+
+  dcs[0].send(slice);
+  t.equal(backing.length, 6, 'backing buffer still usable');
+});
+
+test('data channel delivers node buffers', function(t) {
+  t.plan(4);
+  dcs[1].binaryType = 'nodebuffer';
+  t.equal(dcs[1].binaryType, 'nodebuffer', 'binaryType accepted');
+
+  dcs[1].onmessage = function(evt) {
+    t.ok(Buffer.isBuffer(evt.data), 'got a Buffer');
+    t.deepEqual(Array.prototype.slice.call(evt.data), [7, 8, 9], 'payload matches');
+    dcs[1].binaryType = 'arraybuffer';
+  };
+
+  dcs[0].send(new Buffer([7, 8, 9]));
+  t.pass('successfully called send on dc:0');
+});
+
+test('data channel round-trips large and non-ascii text', function(t) {
+  var large = new Array(4097).join('x');
+  var unicode = 'h\u00e9llo \u2603';
+  var expected = [large, unicode];
+
+  t.plan(2);
+  dcs[1].onmessage = function(evt) {
+    t.equal(evt.data, expected.shift(), 'text matches');
+  };
+
+  dcs[0].send(large);
+  dcs[0].send(unicode);
+});
+
+test('data channel sends many messages in one call', function(t) {
+  var expected = ['one', 'two', 'three'];
+
+  t.plan(4);
+  dcs[1].onmessage = function(evt) {
+    var data = evt.data;
+    if (typeof data !== 'string') {
+      data = String.fromCharCode.apply(null, new Uint8Array(data));
+    }
+    t.equal(data, expected.shift(), 'message arrives in order');
+  };
+
+  t.equal(dcs[0].sendMany(['one', new Buffer('two'), 'three']), 3, 'all messages accepted');
+});
+
+test('data channel reassembles framed messages', function(t) {
+  var payload = new Buffer(100 * 1024);
+  for (var i = 0; i < payload.length; i++) {
+    payload[i] = i & 0xff;
+  }
+
+  t.plan(3);
+  dcs[0].framing = true;
+  dcs[1].framing = true;
+  dcs[0].maxChunkSize = 4096;
+  var received = dcs[1].getMetrics().messagesReceived;
+  dcs[1].onmessage = function(evt) {
+    var data = new Buffer(new Uint8Array(evt.data));
+    t.equal(data.length, payload.length, 'reassembled length matches');
+    t.ok(data.equals(payload), 'reassembled bytes match');
+    t.equal(dcs[1].getMetrics().messagesReceived, received + 1, 'counted as one message');
+  };
+
+  dcs[0].send(payload);
+});
+
+test('data channel resyncs after a framing error', function(t) {
+  // A first frame that declares an oversized message, then the last frame
+  // of that same broken message, written raw.
+  var oversized = new Buffer([4, 0, 0, 0, 0x7f, 0xff, 0xff, 0xff, 1, 2, 3]);
+  var tail = new Buffer([1, 0, 0, 0, 0x7f, 0xff, 0xff, 0xff, 4, 5, 6]);
+  var errors = 0;
+
+  t.plan(2);
+  dcs[1].onerror = function() {
+    errors++;
+  };
+  dcs[1].onmessage = function(evt) {
+    t.equal(errors, 1, 'one error for the broken message');
+    t.equal(evt.data, 'after', 'next message is delivered intact');
+    dcs[1].onerror = null;
+  };
+
+  dcs[0].framing = false;
+  dcs[0].send(oversized);
+  dcs[0].send(tail);
+  dcs[0].framing = true;
+  dcs[0].send('after');
+});
+
+test('data channel drops a framed message cut short by a failed send', function(t) {
+  // The first frame of a 200 byte message, written raw with the rest never
+  // sent, then a whole message of the same length in 56 byte chunks.
+  var truncated = new Buffer(8 + 56);
+  truncated.fill(0);
+  truncated[0] = 4;
+  truncated[7] = 200;
+  var payload = new Buffer(200);
+  for (var i = 0; i < payload.length; i++) {
+    payload[i] = (i * 7) & 0xff;
+  }
+  var errors = 0;
+
+  t.plan(3);
+  dcs[1].onerror = function() {
+    errors++;
+  };
+  dcs[1].onmessage = function(evt) {
+    var data = new Buffer(new Uint8Array(evt.data));
+    t.equal(errors, 1, 'one error for the cut-short message');
+    t.equal(data.length, payload.length, 'length matches');
+    t.ok(data.equals(payload), 'next message is delivered intact');
+    dcs[1].onerror = null;
+    dcs[0].maxChunkSize = 4096;
+  };
+
+  dcs[0].framing = false;
+  dcs[0].send(truncated);
+  dcs[0].framing = true;
+  dcs[0].maxChunkSize = 64;
+  dcs[0].send(payload);
+});
+
+test('data channel delivers framed chunks progressively', function(t) {
+  var text = new Array(10001).join('y');
+  var received = 0;
+  var chunks = 0;
+
+  t.plan(2);
+  dcs[1].chunkEvents = true;
+  dcs[1].onmessage = function() {
+    t.fail('onmessage called with chunkEvents set');
+  };
+  dcs[1].onchunk = function(evt) {
+    received += evt.data.byteLength;
+    chunks++;
+    if (evt.last) {
+      t.equal(received, text.length, 'every chunk arrived');
+      t.ok(chunks > 1, 'message arrived in several chunks');
+      dcs[1].onchunk = null;
+      dcs[1].chunkEvents = false;
+      dcs[0].framing = false;
+      dcs[1].framing = false;
+    }
+  };
+
+  dcs[0].send(text);
+});
+
+test('data channel writes into a receive ring', { skip: typeof SharedArrayBuffer === 'undefined' }, function(t) {
+  var ring = new SharedArrayBuffer(64 * 1024);
+  var reader = new wrtc.RTCDataChannelRingReader(ring);
+  var received = [];
+
+  t.plan(2);
+  dcs[1].onmessage = function() {
+    t.fail('onmessage called while a receive ring is set');
+  };
+  dcs[1].onringdata = function() {
+    var message;
+    while ((message = reader.read()) !== null) {
+      received.push(typeof message === 'string' ? message : Array.prototype.slice.call(message));
+    }
+    if (received.length === 2) {
+      t.deepEqual(received, ['ring', [1, 2, 3]], 'messages read from the ring');
+      t.equal(reader.dropped, 0, 'nothing dropped');
+      dcs[1].setReceiveRing(null);
+      dcs[1].onringdata = null;
+    }
+  };
+
+  dcs[1].setReceiveRing(ring);
+  dcs[0].send('ring');
+  dcs[0].send(new Uint8Array([1, 2, 3]));
+});
+
+test('data channel batched delivery', function(t) {
+  var received = [];
+
+  t.plan(3);
+  dcs[1].onmessage = function() {
+    t.fail('onmessage called while batching');
+  };
+  dcs[1].onmessages = function(evt) {
+    received = received.concat(evt.data);
+    if (received.length === 3) {
+      t.deepEqual(received, ['a', 'b', 'c'], 'messages arrive in order');
+      dcs[1].batchMessages = false;
+      dcs[1].onmessages = null;
+    }
+  };
+
+  dcs[1].batchMessages = true;
+  t.equal(dcs[1].batchMessages, true, 'batching enabled');
+
+  dcs[0].send('a');
+  dcs[0].send('b');
+  dcs[0].send('c');
+  t.pass('successfully called send on dc:0');
+});
+
+test('data channel fires bufferedamountlow once drained', function(t) {
+  var threshold = 16 * 1024;
+  var chunk = new ArrayBuffer(16 * 1024);
+  var timeout;
+
+  t.plan(2);
+  dcs[1].onmessage = null;
+  dcs[0].bufferedAmountLowThreshold = threshold;
+  t.equal(dcs[0].bufferedAmountLowThreshold, threshold, 'threshold accepted');
+
+  dcs[0].onbufferedamountlow = function() {
+    dcs[0].onbufferedamountlow = null;
+    clearTimeout(timeout);
+    t.ok(dcs[0].bufferedAmount <= threshold, 'buffered amount dropped below threshold');
+  };
+
+  timeout = setTimeout(function() {
+    dcs[0].onbufferedamountlow = null;
+    t.fail('bufferedamountlow did not fire');
+  }, 5000);
+
+  // 256 KiB in one go is well past the threshold, so the drain has to cross
+  // it, while staying small enough to send synchronously.
+  for (var i = 0; i < 16; i++) {
+    dcs[0].send(chunk);
+  }
+});
+
+test('buffer pool recycles message buffers', function(t) {
+  // Text, so each message block goes back to the pool as soon as it has been
+  // converted rather than when V8 collects an ArrayBuffer.
+  var message = new Array(1001).join('x');
+  var count = 20;
+  var received = 0;
+  var before = wrtc.getBufferPoolStats();
+
+  t.plan(4);
+  dcs[1].onmessage = function() {
+    if (++received < count) {
+      // One at a time, so each message can reuse the block of the last.
+      return dcs[0].send(message);
+    }
+    var stats = wrtc.getBufferPoolStats();
+    t.ok(stats.hits + stats.misses > before.hits + before.misses, 'messages were allocated from the pool');
+    t.ok(stats.hits > before.hits, 'same-size messages reuse pooled blocks');
+    t.ok(stats.hitRate > 0 && stats.hitRate <= 1, 'hit rate is a ratio');
+    t.equal(typeof stats.bytesRetained, 'number', 'reports retained bytes');
+  };
+
+  dcs[0].send(message);
+});
+
+test('event payloads are counted', function(t) {
+  var stats = wrtc.getEventStats();
+
+  t.plan(3);
+  t.ok(stats.created > 0, 'events were created');
+  t.ok(stats.liveEvents < stats.created, 'handled events were freed');
+  t.equal(typeof stats.liveBytes, 'number', 'reports live bytes');
+});
+
+test('getMetrics counts messages and events', function(t) {
+  var channel = dcs[0].getMetrics();
+  var connection = peers[0].getMetrics();
+  var total = wrtc.getMetrics();
+
+  t.plan(5);
+  t.ok(channel.messagesSent > 0 && channel.bytesSent > 0, 'channel counted sends');
+  t.ok(channel.eventsDrained <= channel.eventsQueued, 'drained never exceeds queued');
+  t.ok(connection.messagesSent >= channel.messagesSent, 'connection includes its channels');
+  t.ok(total.messagesSent >= connection.messagesSent, 'process totals include connections');
+  t.ok(total.wakeups > 0 && total.drainTimeNs > 0, 'wakeups and drain time are counted');
+});
+
+test('receiveTimestamps and delivery latency', function(t) {
+  t.plan(4);
+  dcs[1].receiveTimestamps = true;
+  dcs[1].onmessage = function(evt) {
+    var now = process.hrtime();
+    dcs[1].onmessage = null;
+    dcs[1].receiveTimestamps = false;
+
+    t.equal(typeof evt.receivedAt, 'number', 'message carries its receive time');
+    t.ok(evt.receivedAt <= now[0] * 1e3 + now[1] / 1e6, 'received before it was handled');
+
+    // Read on the next turn, once this event has been recorded.
+    setImmediate(function() {
+      var latency = dcs[1].getLatency(true);
+      t.ok(latency.count > 0, 'deliveries were recorded');
+      t.ok(latency.p50 <= latency.p99 && latency.p99 <= latency.p999, 'percentiles are ordered');
+    });
+  };
+  dcs[0].send('timestamped');
+});
+
+test('receiveTimestamps with batched delivery', function(t) {
+  t.plan(2);
+  dcs[1].batchMessages = true;
+  dcs[1].receiveTimestamps = true;
+  dcs[1].onmessages = function(evt) {
+    dcs[1].onmessages = null;
+    dcs[1].batchMessages = false;
+    dcs[1].receiveTimestamps = false;
+
+    t.equal(evt.receivedAt.length, evt.data.length, 'one receive time per message');
+    t.equal(typeof evt.receivedAt[0], 'number', 'receive times are numbers');
+  };
+  dcs[0].send('batched');
+});
+
 test('getStats', function(t) {
   t.plan(2);
 
@@ -235,6 +561,131 @@ test('getStats', function(t) {
   });
 });
 
+test('RTCStatsReport.stat looks up typed values', function(t) {
+  t.plan(3);
+
+  peers[0].getStats(function(response) {
+    var reports = response.result();
+    var numeric = reports.some(function(report) {
+      return report.names().some(function(name) {
+        return typeof report.stat(name) === 'number';
+      });
+    });
+    var report = reports[0];
+    var name = report.names()[0];
+
+    t.notEqual(report.stat(name), undefined, 'known stat is found');
+    t.equal(report.stat('no such stat'), undefined, 'unknown stat is undefined');
+    t.ok(numeric, 'numeric stats are numbers');
+  }, function(error) {
+    t.fail(error);
+  });
+});
+
+test('getStatsObject', function(t) {
+  t.plan(4);
+
+  peers[0].getStatsObject(function(reports) {
+    var ids = Object.keys(reports);
+    t.ok(ids.length > 0, 'got reports');
+
+    var report = reports[ids[0]];
+    t.equal(report.id, ids[0], 'reports are keyed by id');
+    t.equal(typeof report.timestamp, 'number', 'timestamp is a number');
+
+    var numeric = ids.some(function(id) {
+      return Object.keys(reports[id]).some(function(name) {
+        return typeof reports[id][name] === 'number' && name !== 'timestamp';
+      });
+    });
+    t.ok(numeric, 'numeric stats are numbers');
+  }, function(error) {
+    t.fail(error);
+  });
+});
+
+test('getStatsObject with a selector', function(t) {
+  t.plan(2);
+
+  peers[0].getStatsObject(function(all) {
+    var type = all[Object.keys(all)[0]].type;
+
+    peers[0].getStatsObject(function(reports) {
+      var ids = Object.keys(reports);
+      t.ok(ids.length > 0, 'got matching reports');
+      t.ok(ids.every(function(id) {
+        return reports[id].type === type;
+      }), 'only reports of the selected type');
+    }, function(error) {
+      t.fail(error);
+    }, { types: [type] });
+  }, function(error) {
+    t.fail(error);
+  });
+});
+
+test('RTCStatsSampler emits aggregated snapshots', function(t) {
+  var sampler = new wrtc.RTCStatsSampler(50);
+  var ticks = 0;
+
+  t.plan(5);
+  sampler.add(peers[0], 'peer0');
+  sampler.add(peers[1], 'peer1');
+  sampler.ontick = function(snapshot) {
+    ticks++;
+    if (ticks === 1) {
+      t.equal(snapshot.peers.length, 2, 'one entry per peer');
+      t.equal(snapshot.peers[0].label, 'peer0', 'entries keep their label');
+      t.equal(typeof snapshot.total.bytesSent, 'number', 'totals are numbers');
+    } else if (ticks === 2) {
+      t.ok(snapshot.total.bytesSentPerSecond >= 0, 'rates are computed');
+      t.ok(sampler.remove(peers[1]), 'peer removed');
+      sampler.stop();
+    }
+  };
+  sampler.start();
+});
+
+test('native tracing exports chrome trace events', function(t) {
+  t.plan(3);
+  wrtc.setTracing(true);
+  peers[0].getStatsObject(function() {
+    wrtc.setTracing(false);
+
+    var events = JSON.parse(wrtc.getTrace()).traceEvents;
+    t.ok(events.length > 0, 'recorded events');
+    t.ok(events.some(function(evt) {
+      return evt.ph === 'B' && /GetStats/.test(evt.name);
+    }), 'recorded the getStats call');
+    t.ok(events.every(function(evt) {
+      return evt.ph === 'M' || typeof evt.ts === 'number';
+    }), 'events are timestamped');
+  }, function(error) {
+    t.fail(error);
+  });
+});
+
+test('setLogger receives native log lines', function(t) {
+  t.plan(3);
+  wrtc.setLogSeverity('info');
+  wrtc.setLogger(function(lines, dropped) {
+    var line = lines.filter(function(line) {
+      return line.source === 'native';
+    })[0];
+    if (!line) {
+      return;
+    }
+    wrtc.setLogger(null);
+
+    t.equal(line.severity, 'info', 'line carries its severity');
+    t.equal(line.message, 'PeerConnection::ReadOnly', 'line carries its message');
+    t.equal(typeof dropped, 'number', 'dropped lines are counted');
+  });
+
+  // Writing a read-only property logs at info level.
+  peers[0]._pc.localDescription = null;
+});
+
 test('close the connections', function(t) {
   t.plan(1);
   peers[0].close();
@@ -243,3 +694,34 @@ test('close the connections', function(t) {
 
   peers = [];
 });
+
+test('a closed data channel is garbage collected', { skip: typeof FinalizationRegistry === 'undefined' }, function(t) {
+  t.plan(1);
+  require('v8').setFlagsFromString('--expose-gc');
+  var gc = require('vm').runInNewContext('gc');
+  var collected = false;
+  var registry = new FinalizationRegistry(function() {
+    collected = true;
+  });
+
+  (function() {
+    var pc = new RTCPeerConnection({ iceServers: [] });
+    var dc = pc.createDataChannel('collect');
+    dc.onmessage = function() {};
+    registry.register(dc, 'dc');
+    dc.close();
+    pc.close();
+  })();
+
+  var attempts = 0;
+  (function poll() {
+    gc();
+    if (collected) {
+      return t.pass('wrapper was collected');
+    }
+    if (++attempts > 50) {
+      return t.fail('closed data channel was never collected');
+    }
+    setTimeout(poll, 20);
+  })();
+});
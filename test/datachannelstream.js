@@ -0,0 +1,59 @@
+'use strict';
+
+var test = require('tape');
+var SimplePeer = require('simple-peer');
+
+var wrtc = require('..');
+var RTCDataChannelStream = wrtc.RTCDataChannelStream;
+
+
+var peer1;
+var peer2;
+var streams = [];
+
+
+test('connect two peers', function(t) {
+  t.plan(1);
+  peer1 = new SimplePeer({ wrtc: wrtc, initiator: true });
+  peer2 = new SimplePeer({ wrtc: wrtc });
+  peer1.on('signal', peer2.signal.bind(peer2));
+  peer2.on('signal', peer1.signal.bind(peer1));
+  peer1.on('connect', function() {
+    t.pass('peers connected');
+  });
+});
+
+test('pipe through data channel streams with backpressure', function(t) {
+  var chunk = new Buffer(16 * 1024);
+  var total = 256;
+  var written = 0;
+  var received = 0;
+
+  t.plan(1);
+  streams.push(new RTCDataChannelStream(peer1._channel, { highWaterMark: 64 * 1024 }));
+  streams.push(new RTCDataChannelStream(peer2._channel));
+
+  streams[1].on('data', function(data) {
+    received += data.length;
+    if (received === total * chunk.length) {
+      t.pass('received every byte');
+    }
+  });
+
+  (function write() {
+    while (written < total) {
+      written++;
+      if (!streams[0].write(chunk)) {
+        streams[0].once('drain', write);
+        return;
+      }
+    }
+  })();
+});
+
+test('close the peers', function(t) {
+  t.plan(1);
+  peer1.destroy();
+  peer2.destroy();
+  t.pass('closed peers');
+});
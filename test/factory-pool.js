@@ -0,0 +1,59 @@
+'use strict';
+
+var test = require('tape');
+
+var wrtc = require('..');
+var RTCPeerConnection = wrtc.RTCPeerConnection;
+
+
+var peers = [];
+
+
+test('setFactoryPoolSize rejects an empty pool', function(t) {
+  t.plan(1);
+  t.throws(function() {
+    wrtc.setFactoryPoolSize(0);
+  }, 'throws on size 0');
+});
+
+test('setFactoryPoolSize updates the pool size', function(t) {
+  t.plan(1);
+  wrtc.setFactoryPoolSize(2);
+  t.equal(wrtc.getFactoryPoolSize(), 2, 'pool size is 2');
+});
+
+test('more peer connections than factories can be created', function(t) {
+  var count = 5;
+  var fail = t.ifError.bind(t);
+
+  t.plan(count);
+  for (var i = 0; i < count; i++) {
+    peers.push(new RTCPeerConnection({ iceServers: [] }));
+  }
+  peers.forEach(function(peer) {
+    peer.createOffer(function(desc) {
+      t.equal(desc.type, 'offer', 'createOffer succeeded');
+    }, fail);
+  });
+});
+
+test('close the connections', function(t) {
+  t.plan(1);
+  peers.forEach(function(peer) {
+    peer.close();
+  });
+  peers = [];
+  t.pass('closed connections');
+});
+
+test('shrinking the pool keeps new connections working', function(t) {
+  t.plan(2);
+  wrtc.setFactoryPoolSize(1);
+  t.equal(wrtc.getFactoryPoolSize(), 1, 'pool size is 1');
+
+  var peer = new RTCPeerConnection({ iceServers: [] });
+  peer.createOffer(function(desc) {
+    t.equal(desc.type, 'offer', 'createOffer succeeded');
+    peer.close();
+  }, t.ifError.bind(t));
+});
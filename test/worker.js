@@ -0,0 +1,129 @@
+'use strict';
+
+var test = require('tape');
+
+var workerThreads;
+try {
+  workerThreads = require('worker_threads');
+} catch (err) {
+  workerThreads = null;
+}
+
+
+// Runs inside the worker: create a connection, make an offer, report back.
+function workerMain() {
+  var parentPort = require('worker_threads').parentPort;
+  var wrtc = require('..');
+  var pc = new wrtc.RTCPeerConnection({ iceServers: [] });
+  pc.createDataChannel('worker');
+  pc.createOffer(function(desc) {
+    parentPort.postMessage(desc.type);
+    pc.close();
+  }, function(err) {
+    parentPort.postMessage('error: ' + err);
+    pc.close();
+  });
+}
+
+// Runs inside the worker: connect two peers, keep both ends of a channel
+// sending to each other, and report once messages are flowing. The worker is
+// then terminated with everything still open.
+function connectedWorkerMain() {
+  var parentPort = require('worker_threads').parentPort;
+  var wrtc = require('..');
+  var peers = [
+    new wrtc.RTCPeerConnection({ iceServers: [] }),
+    new wrtc.RTCPeerConnection({ iceServers: [] })
+  ];
+  var fail = function(err) {
+    parentPort.postMessage('error: ' + err);
+  };
+  var received = 0;
+
+  function chatter(channel) {
+    setInterval(function() {
+      channel.send('chatter');
+    }, 1);
+    channel.onmessage = function() {
+      if (++received === 10) {
+        parentPort.postMessage('flowing');
+      }
+    };
+  }
+
+  peers.forEach(function(peer, i) {
+    peer.onicecandidate = function(evt) {
+      if (evt.candidate) {
+        peers[1 - i].addIceCandidate(new wrtc.RTCIceCandidate(evt.candidate), function() {}, fail);
+      }
+    };
+  });
+  peers[1].ondatachannel = function(evt) {
+    evt.channel.onopen = function() {
+      chatter(evt.channel);
+    };
+  };
+
+  var channel = peers[0].createDataChannel('worker');
+  channel.onopen = function() {
+    chatter(channel);
+  };
+
+  peers[0].createOffer(function(offer) {
+    peers[0].setLocalDescription(offer, function() {
+      peers[1].setRemoteDescription(peers[0].localDescription, function() {
+        peers[1].createAnswer(function(answer) {
+          peers[1].setLocalDescription(answer, function() {
+            peers[0].setRemoteDescription(peers[1].localDescription, function() {}, fail);
+          }, fail);
+        }, fail);
+      }, fail);
+    }, fail);
+  }, fail);
+}
+
+if (workerThreads && !workerThreads.isMainThread) {
+  return 'connected' === workerThreads.workerData ? connectedWorkerMain() : workerMain();
+}
+
+
+test('peer connections work inside worker threads', { skip: !workerThreads }, function(t) {
+  var count = 2;
+
+  t.plan(count * 2);
+  for (var i = 0; i < count; i++) {
+    var worker = new workerThreads.Worker(__filename);
+    worker.on('message', function(type) {
+      t.equal(type, 'offer', 'createOffer succeeded in a worker');
+    });
+    worker.on('exit', function(code) {
+      t.equal(code, 0, 'worker exited cleanly');
+    });
+  }
+});
+
+test('a worker exiting with an open channel releases it', { skip: !workerThreads }, function(t) {
+  var wrtc = require('..');
+  var worker = new workerThreads.Worker(__filename, { workerData: 'connected' });
+  var timeout = setTimeout(function() {
+    t.fail('worker never got its channel going');
+    worker.terminate();
+  }, 10000);
+
+  t.plan(2);
+  worker.on('message', function(message) {
+    clearTimeout(timeout);
+    t.equal(message, 'flowing', 'messages flow inside the worker');
+    worker.terminate();
+  });
+  worker.on('exit', function() {
+    // Once the worker's connections are torn down nothing queues events for
+    // it any more, so the process-wide count of live events stops growing.
+    setTimeout(function() {
+      var before = wrtc.getEventStats().liveEvents;
+      setTimeout(function() {
+        t.ok(wrtc.getEventStats().liveEvents <= before, 'no events pile up after exit');
+      }, 500);
+    }, 100);
+  });
+});